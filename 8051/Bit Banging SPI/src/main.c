@@ -7,6 +7,11 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "uart.h"
+#include "pwm.h"
+#include "startup.h"
+#include "timebase.h"
+#include "sched.h"
+#include "irq.h"
 
 /* DAC Control Pins */
 #define sck P1_6        // SPI Clock
@@ -19,8 +24,8 @@
 #define Gain_increase_mask 0xFFFF  // Mask for gain increase
 #define Gain_decrease_mask 0x7FFF  // Mask for gain decrease
 
-//data points for the wave
-__xdata uint8_t static sine_wave[160] = {
+//data points for the wave, kept in code so startup does not copy them to XRAM
+STARTUP_TABLE uint8_t static sine_wave[160] = {
     128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174,
     177, 180, 182, 185, 188, 191, 194, 196, 199, 201, 204, 206, 209, 211, 214, 216,
     217, 215, 212, 210, 208, 205, 203, 200, 197, 195, 192, 189, 187, 184, 181, 178,
@@ -33,9 +38,14 @@ __xdata uint8_t static sine_wave[160] = {
      82,  85,  88,  91,  94,  97, 100, 103, 106, 109, 112, 116, 119, 122, 125, 128,
 };
 
-/* GLOBAL Variables */
-__xdata uint16_t counter = 0;
-uint8_t gain = 1;  // Default gain setting
+/* Output backends */
+#define DAC_BACKEND_SPI 0   // Bit-banged MCP48x2, Timer 0 at 900 Hz
+#define DAC_BACKEND_PWM 1   // PCA 8-bit PWM + RC filter at 3600 Hz
+
+/* GLOBAL Variables, read on every Timer 0 sample so kept in internal RAM */
+__data uint16_t counter = 0;
+__data uint8_t gain = 1;  // Default gain setting
+uint8_t dac_backend = DAC_BACKEND_SPI;
 
 /* SPI Bit-Banging Functions */
 
@@ -101,6 +111,7 @@ void dac_decrease_voltage(void) {
 
 /* Timer 0 Interrupt Handler */
 void wave_interrupt_handler(void) __interrupt(1) {
+    IRQ_MEASURE_TIMER0();  // Before the reload, TH0:TL0 is the entry latency
     TF0 = 0;       // Clear Timer 0 overflow flag
     TL0 = 0x00;    // Reload Timer 0
     TH0 = 0xFC;    // Reload Timer 0
@@ -117,33 +128,81 @@ void waves_init(void) {
     TR0 = 1;       // Start Timer 0
 }
 
+/* Output Backend Selection */
+void dac_set_backend(uint8_t backend) {
+    if (backend == DAC_BACKEND_PWM) {
+        TR0 = 0;       // Stop the bit-banged updates
+        // The PWM pin is high once CL reaches CCAP1L, so invert the samples
+        for (uint8_t i = 0; i < PWM_TABLE_SIZE; i++) {
+            pwm_table[i] = 0xFF - sine_wave[i];
+        }
+        pwm_start();
+    } else {
+        pwm_stop();
+        TR0 = 1;       // Resume the bit-banged updates
+    }
+    dac_backend = backend;
+}
+
+/* Console Task */
+static void console_command(uint8_t key_pressed) {
+    switch (key_pressed) {
+        case '+':
+            dac_increase_voltage();
+            printf("\n\rVoltage Increased\n\r");
+            break;
+        case '-':
+            dac_decrease_voltage();
+            printf("\n\rVoltage Decreased\n\r");
+            break;
+        case 'T':
+        case 't':
+            if (dac_backend == DAC_BACKEND_SPI) {
+                dac_set_backend(DAC_BACKEND_PWM);
+                printf("\n\rOutput: PCA PWM on P1.4\n\r");
+            } else {
+                dac_set_backend(DAC_BACKEND_SPI);
+                printf("\n\rOutput: bit-banged DAC\n\r");
+            }
+            break;
+        case 'C':
+        case 'c':
+            sched_print_stats();
+            irq_print_stats();
+            break;
+        case '?':
+            printf("\n\rCommands: \n\r'+'-> Increase Voltage,\n\r '-'-> Decrease Voltage,\n\r 'T'-> Toggle DAC / PCA PWM output,\n\r 'C'-> Task statistics,\n\r '?'-> Display Menu");
+            break;
+        default:
+            printf("\n\rInvalid Command");
+            break;
+    }
+}
+
+// Posted by the serial ISR for each byte that arrives
+void console_task(void) {
+    __xdata uint8_t key_pressed;
+
+    while (!RING_EMPTY(uart_rx)) {
+        RING_GET(uart_rx, key_pressed);
+        console_command(key_pressed);
+    }
+}
+
 /* Main Function */
 void main(void) {
-    __xdata uint8_t key_pressed;
+    startup_time_us();  // Before anything else touches Timer 2
 
+    irq_init();        // Priority levels from the latency budgets (irq.h)
     initialize_UART(); // Initialize UART
+    timebase_init();   // 1 ms tick for the scheduler
     waves_init();      // Initialize Timer for waveform updates
 
     printf("\n\rWelcome to DAC wave generator");
-    printf("\n\rCommands: \n\r'+'-> Increase the Voltage, \n\r'-'-> Decrease the Voltage, \n\r'?'-> help");
-
-    while (1) {
-        key_pressed = getchar();
-        switch (key_pressed) {
-            case '+':
-                dac_increase_voltage();
-                printf("\n\rVoltage Increased\n\r");
-                break;
-            case '-':
-                dac_decrease_voltage();
-                printf("\n\rVoltage Decreased\n\r");
-                break;
-            case '?':
-                printf("\n\rCommands: \n\r'+'-> Increase Voltage,\n\r '-'-> Decrease Voltage,\n\r '?'-> Display Menu");
-                break;
-            default:
-                printf("\n\rInvalid Command");
-                break;
-        }
-    }
+    printf("\n\rC startup: ");
+    startup_print();
+    printf("\n\rCommands: \n\r'+'-> Increase the Voltage, \n\r'-'-> Decrease the Voltage, \n\r'T'-> Toggle DAC / PCA PWM output, \n\r'C'-> Task statistics, \n\r'?'-> help");
+
+    uart_rx_task = sched_add("console", console_task, 0);
+    sched_run();
 }
@@ -0,0 +1,46 @@
+// Author: Lokesh Senthil Kumar
+// pwm.c file plays the waveform table on the PCA PWM output
+
+#include "at89c51ed2.h"
+#include "mcs51reg.h"
+#include <stdint.h>
+#include "pwm.h"
+#include "irq.h"
+
+__xdata uint8_t pwm_table[PWM_TABLE_SIZE];
+volatile __data uint8_t pwm_index = 0;
+
+void pca_isr(void) __interrupt(6) __using(IRQ_BANK(PCA))
+{
+    IRQ_NOTE_LATENCY(IRQ_PCA_VECTOR, CL);  // CL counts machine cycles from the overflow
+    CH = PCA_CH_RELOAD;     // Interrupt again after 256 counts, not 65536
+    CF = 0;
+    CCAP1H = pwm_table[pwm_index];  // Copied to CCAP1L at the next overflow
+    if (++pwm_index == PWM_TABLE_SIZE) {
+        pwm_index = 0;
+    }
+}
+
+void pwm_start(void)
+{
+    CR = 0;
+    CMOD = PCA_CMOD_FOSC_12 | PCA_CMOD_ECF;
+    CL = 0;
+    CH = PCA_CH_RELOAD;
+
+    pwm_index = 0;
+    CCAP1L = CCAP1H = pwm_table[0];
+    CCAPM1 = PCA_CCAPM_PWM;
+
+    CF = 0;
+    IEN0 |= PCA_IEN0_EC;
+    CR = 1;                 // Run the PCA counter
+}
+
+void pwm_stop(void)
+{
+    IEN0 &= ~PCA_IEN0_EC;
+    CR = 0;
+    CCAPM1 = 0;
+    CF = 0;
+}
@@ -0,0 +1,47 @@
+// Author: Lokesh Senthil Kumar
+// pwm.h file declares the PCA 8-bit PWM output backend
+
+#ifndef _PWM_H_
+#define _PWM_H_
+
+#include <stdint.h>
+#include "irq.h"
+
+/*
+ * PCA module 1 runs in 8-bit PWM mode on CEX1 (P1.4); an RC low-pass filter
+ * on the pin gives the analog output. The PCA counts at Fosc/12, so CL
+ * overflows every 256 machine cycles: a 3600 Hz carrier. CF is only set
+ * when all of CH:CL overflows, so the ISR puts 0xFF back in CH each time and
+ * the next CL overflow carries out. That gives a 3600 Hz sample rate,
+ * against 900 Hz for the bit-banged DAC, and one register write per sample
+ * instead of 16 clocked bits.
+ */
+#define PCA_CH_RELOAD       0xFF    // CH:CL overflows with the next CL overflow
+#define PWM_TABLE_SIZE      160     // One period, same length as sine_wave
+
+#define PCA_CMOD_FOSC_12    0x00    // CPS1:0 = 00, PCA clock = Fosc/12
+#define PCA_CMOD_ECF        0x01    // Interrupt on CH:CL overflow
+#define PCA_CCAPM_PWM       0x42    // ECOM | PWM
+#define PCA_IEN0_EC         0x40    // PCA interrupt enable in IEN0
+
+// CCAP1H values for one period, filled before pwm_start()
+extern __xdata uint8_t pwm_table[PWM_TABLE_SIZE];
+
+/**
+ * @brief   PCA overflow interrupt; loads the next duty cycle.
+ * @details Calls nothing, so it runs on its own register bank. The prototype
+ *          must stay visible to main.c for the vector table.
+ */
+void pca_isr(void) __interrupt(6) __using(IRQ_BANK(PCA));
+
+/**
+ * @brief   Starts the PCA PWM output and the PCA overflow interrupt.
+ */
+void pwm_start(void);
+
+/**
+ * @brief   Stops the PCA and returns CEX1 to a port pin.
+ */
+void pwm_stop(void);
+
+#endif // _PWM_H_
@@ -1,6 +1,26 @@
 #ifndef _UART_H_
 #define _UART_H_
 
+#include <stdint.h>
+#include "ring.h"
+
+/*
+ * The serial ISR queues received bytes in uart_rx and posts uart_rx_task;
+ * putchar waits only for the byte before it.
+ */
+#define UART_RX_SIZE        16
+
+RING_EXTERN(uart_rx, uint8_t, UART_RX_SIZE, __xdata);
+
+// Task posted when a byte arrives, SCHED_NO_TASK for none
+extern __data uint8_t uart_rx_task;
+
+/**
+ * @brief   Serial ISR for the console.
+ * @details The prototype must stay visible to main.c for the vector table.
+ */
+void uart_isr(void) __interrupt(4);
+
 int getchar (void);
 
 int putchar (int c);
@@ -0,0 +1,34 @@
+// Author: Lokesh Senthil Kumar
+// app_config.h file sets this program's options for the shared modules in ../common
+
+#ifndef _APP_CONFIG_H_
+#define _APP_CONFIG_H_
+
+/* ---- irq.h: interrupt sources; costs are estimates, see irq.h ---- */
+
+/* Longest stretch the foreground keeps a source masked */
+#define IRQ_CRITICAL_US     10
+
+/* External 0, expander change: only posts a task, the edge is latched */
+#define IRQ_EXT0_COST_US        10
+#define IRQ_EXT0_BUDGET_US      300
+#define IRQ_EXT0_MEASURED       0
+
+/* Serial, console: SBUF must be read before the next byte (1 ms) */
+#define IRQ_SERIAL_COST_US      15
+#define IRQ_SERIAL_BUDGET_US    500
+#define IRQ_SERIAL_MEASURED     0
+
+/* Timer 2, 1 ms tick: only has to finish inside the tick */
+#define IRQ_TIMER2_COST_US      20
+#define IRQ_TIMER2_BUDGET_US    900
+#define IRQ_TIMER2_MEASURED     1
+
+#define IRQ_LIST(X, arg)    X(EXT0, arg) X(SERIAL, arg) X(TIMER2, arg)
+
+/* ---- defer.h: deferred handlers, highest priority first ---- */
+
+#define DEFER_EXPANDER      0       // restart the expander debounce timer
+#define DEFER_COUNT         1
+
+#endif // _APP_CONFIG_H_
@@ -21,6 +21,13 @@
  * - 'R' or 'r': Read data from EEPROM.
  * - 'D' or 'd': Hex dump of EEPROM.
  * - 'S' or 's': Reset EEPROM.
+ * - 'C' or 'c': Task statistics.
+ *
+ * The console and the expander run as scheduler tasks; /INT0 only posts the
+ * expander task, so the I2C transfer happens outside the interrupt. Edges
+ * are debounced on a software timer before the expander is read. The
+ * serial ISR posts the console task, and the EEPROM prompts take one key
+ * at a time, so typing never holds up the expander.
  *
  *****************************************************************************/
 
@@ -33,8 +40,15 @@
 #include <at89c51ed2.h>
 #include <mcs51reg.h>
 #include "driver.h"
+#include "i2c.h"
 #include "uart.h"
 #include "process_command.h"
+#include "startup.h"
+#include "timebase.h"
+#include "sched.h"
+#include "swtimer.h"
+#include "defer.h"
+#include "irq.h"
 
 /**
  * @brief Processes the user input command and calls the respective EEPROM control functions.
@@ -45,6 +59,7 @@
  *              - 'R' or 'r': Read data from EEPROM.
  *              - 'D' or 'd': Hex dump of EEPROM.
  *              - 'S' or 's': Reset EEPROM.
+ *              - 'C' or 'c': Task statistics.
  *            Any other character prompts an error message and displays the command menu.
  */
 void COMMAND_CONTROL(char COM);
@@ -54,15 +69,29 @@ void COMMAND_CONTROL(char COM);
 //external interrupt configuration for to trigger the change the i/o expander
 void initialize_interrupt(void) {
     IT0 = 1;      		        /* Interrupt0 on falling edge */
-	EX0 = 1;      		        /* Enable External interrupt0 */
-	IP = 0x01;		            /* Set highest priority for Ext. interrupt0 */
+	EX0 = 1;      		        /* Enable External interrupt0, irq_init sets its priority */
 }
 
 
-//external interrupt handler
-void external_interrupt0_ISR(void) __interrupt (0) {
+#define EXPANDER_DEBOUNCE_MS 20   // quiet time after the last /INT0 edge
+
+// Restarted on every edge, the expander is read once it runs out
+__xdata swtimer_t expander_debounce;
+
+//external interrupt handler, the I2C work is left to expander_edge; it calls
+//nothing, so it switches to its level's register bank
+void external_interrupt0_ISR(void) __interrupt (0) __using(IRQ_BANK(EXT0)) {
+    DEFER_RAISE(DEFER_EXPANDER);
+}
+
+/**
+ * @brief Sets P1 of the PCF8574A to the inverse of P0 once the inputs settle.
+ */
+void expander_settle(uint8_t arg) {
     uint8_t data;
-    printf("\r\nISR works\r\n");
+
+    (void)arg;
+
     // Read current state from PCF8574A
     PCF8574A_write(0xFF);
     data = PCF8574A_read();
@@ -78,6 +107,32 @@ void external_interrupt0_ISR(void) __interrupt (0) {
     PCF8574A_write(data);
 }
 
+/**
+ * @brief Deferred handler of the /INT0 edge, (re)starts the debounce timer.
+ */
+void expander_edge(void) {
+    swtimer_start(&expander_debounce, EXPANDER_DEBOUNCE_MS, 0, expander_settle, 0);
+}
+
+
+/**
+ * @brief Handles the characters the serial ISR has queued.
+ */
+void console_task(void) {
+    char COMMAND;
+
+    // Keys typed during a dump wait for it, the dump posts this task again
+    while (!RING_EMPTY(uart_rx) && !EEPROM_DUMPING()) {
+        RING_GET(uart_rx, COMMAND);   // Read user input
+        if (EEPROM_KEY(COMMAND)) {
+            continue;                 // Answer to an open prompt
+        }
+        COMMAND_CONTROL(COMMAND);     // Process the command
+        if (!EEPROM_BUSY()) {
+            printf("\r\n ENTER THE COMMAND: \r\n");
+        }
+    }
+}
 
 /**
  * @brief Entry point of the program. Initializes peripherals and provides a 
@@ -86,12 +141,20 @@ void external_interrupt0_ISR(void) __interrupt (0) {
  * This function:
  * 1. Initializes UART and I2C interfaces.
  * 2. Displays a menu with supported commands.
- * 3. Enters an infinite loop to process user commands.
+ * 3. Hands the console and the expander to the scheduler.
  *
  * @return int This function does not return as it runs an infinite loop.
  */
 int main(void) {
+    startup_time_us(); // Before anything else touches Timer 2
+
+    irq_init();        // Priority levels from the latency budgets (irq.h)
     initialize_UART(); // Initialize UART for communication
+    timebase_init();   // 1 ms tick for the scheduler
+    swtimer_init();    // Software timers on the same tick
+    printf("\r\n C startup: ");
+    startup_print();
+    printf("\r\n");
     
     initialize_interrupt(); // Initialize interrupt for /INT0
     
@@ -99,8 +162,6 @@ int main(void) {
     PCF8574A_write(0xFF);
     printf("\r\n ---- PCF8574A Interrupt is done ----\r\n");
 
-    char COMMAND;
-
     // Display command menu
     printf("\r\n ------------------------------\r\n");
     printf("\r\n ---- EEPROM I2C Interface ----\r\n");
@@ -110,14 +171,16 @@ int main(void) {
     printf("\r\n R - Read Data from EEPROM\r\n");
     printf("\r\n D - Hex Dump of EEPROM\r\n");
     printf("\r\n S - Reset EEPROM\r\n");
+    printf("\r\n C - Task Statistics\r\n");
     printf("\r\n ------------------------------\r\n");
+    printf("\r\n ENTER THE COMMAND: \r\n");
 
-    // Command processing loop
-    while (1) {
-        printf("\r\n ENTER THE COMMAND: \r\n");
-        COMMAND = getchar();          // Read user input
-        COMMAND_CONTROL(COMMAND);     // Process the command
-    }
+    defer_register(DEFER_EXPANDER, "expander", expander_edge);
+    defer_init();      // First task, so interrupt work runs ahead of the rest
+    sched_add("timers", swtimer_poll, 1);
+    uart_rx_task = sched_add("console", console_task, 0);
+    EEPROM_INIT();     // Dump task, posted once per row
+    sched_run();
 }
 
 // Command handling function implementation
@@ -137,7 +200,7 @@ void COMMAND_CONTROL(char COM) {
             break;
         case 'S':
         case 's':
-            I2C_RESET();     // Reset the EEPROM
+            i2c_reset();     // Reset the EEPROM
             printf("\r\n DONE EEPROM Reset\r\n");
             printf("\r\n Please give the valid command!\r\n");
             printf("\r\n ------------------------------\r\n");
@@ -148,8 +211,17 @@ void COMMAND_CONTROL(char COM) {
             printf("\r\n R - Read Data from EEPROM\r\n");
             printf("\r\n D - Hex Dump of EEPROM\r\n");
             printf("\r\n S - Reset EEPROM\r\n");
+            printf("\r\n C - Task Statistics\r\n");
             printf("\r\n ------------------------------\r\n");
             break;
+        case 'C':
+        case 'c':
+            sched_print_stats();
+            defer_print_stats();
+            swtimer_print_stats();
+            irq_print_stats();
+            i2c_print_stats();
+            break;
         default:
             // Invalid command handling
             printf("\r\n Please give the valid command!\r\n");
@@ -161,6 +233,7 @@ void COMMAND_CONTROL(char COM) {
             printf("\r\n R - Read Data from EEPROM\r\n");
             printf("\r\n D - Hex Dump of EEPROM\r\n");
             printf("\r\n S - Reset EEPROM\r\n");
+            printf("\r\n C - Task Statistics\r\n");
             printf("\r\n ------------------------------\r\n");
             break;
     }
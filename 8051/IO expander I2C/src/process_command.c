@@ -9,6 +9,7 @@
 #include "process_command.h"
 #include "uart.h"
 #include "driver.h"
+#include "sched.h"
 
 #define HEX_BASE        (16)
 #define DIVIDE_BY_16    (16)
@@ -16,52 +17,92 @@
 #define ADDR_MAX        (2047)
 #define ASCII_SPACE     (32)
 
+/* Prompt the next key belongs to */
+#define EEPROM_STEP_NONE        0
+#define EEPROM_STEP_WRITE_DATA  1
+#define EEPROM_STEP_WRITE_ADDR  2
+#define EEPROM_STEP_READ_ADDR   3
+#define EEPROM_STEP_DUMP_START  4
+#define EEPROM_STEP_DUMP_END    5
+#define EEPROM_STEP_DUMPING     6   // no prompt, the dump task prints the rows
+
+__xdata uint8_t eeprom_step = EEPROM_STEP_NONE;
+__xdata uint16_t eeprom_data;
+__xdata uint16_t eeprom_addr;       // also the next address to dump
+__xdata uint16_t eeprom_end_addr;
+__xdata uint8_t eeprom_dump_task = SCHED_NO_TASK;
+
+// Back to commands
+static void eeprom_done(void)
+{
+    eeprom_step = EEPROM_STEP_NONE;
+    printf("\r\n ENTER THE COMMAND: \r\n");
+    sched_post(uart_rx_task);       // keys typed meanwhile are commands
+}
 
-void EEPROM_WRITE(void)
+static void eeprom_prompt(uint8_t step)
 {
-    uint16_t data_read = 0;
-    uint16_t addr_read = 0;
+    eeprom_step = step;
+    INPUT_START();
+}
+
 
+void EEPROM_WRITE(void)
+{
     printf_tiny(" \r\nWriting to EEPROM !!\r\n");
 
     printf_tiny(" \r\nEnter Data to put into EEPROM\r\n");
-    data_read = INPUT_PARSING(HEX_BASE);
+    eeprom_prompt(EEPROM_STEP_WRITE_DATA);
+}
 
-   
+static void eeprom_write_data(uint16_t data_read)
+{
     if(data_read >= 0 && data_read <= ASCII_MAX){}
     else{
         printf("\r\nInvalid Data Range!! \r\nData has to be between 0x00 to 0xFF \r\n");
+        eeprom_done();
         return;
     }
+    eeprom_data = data_read;
 
     printf("\r\n");
 
     printf_tiny("\r\nEnter Address to put into EEPROM\r\n");
-    addr_read = INPUT_PARSING(HEX_BASE );
-    
+    eeprom_prompt(EEPROM_STEP_WRITE_ADDR);
+}
+
+static void eeprom_write_addr(uint16_t addr_read)
+{
     if(addr_read >= 0 && addr_read <= ADDR_MAX){}
     else{
         printf("\r\nInvalid Address Range!!\r\nAddress has to be between 0x000 to 0x7FF\r\n");
+        eeprom_done();
         return;
     }
     printf("\r\n");
 
-    I2C_EEPROM_WRITE(addr_read,data_read);
+    I2C_EEPROM_WRITE(addr_read,eeprom_data);
     printf_tiny("\r\nFinished writting to EEPROM !!\r\n");
+    eeprom_done();
 }
 
 
 void EEPROM_READ(void)
 {
-    __xdata uint16_t addr_read = 0;
-    __xdata uint8_t byte_read1 = 0;
     printf_tiny("\r\nReading from EEPROM !!\r\n");
 
     printf_tiny("\r\nEnter Address to put into EEPROM\r\n");
-    addr_read = INPUT_PARSING(HEX_BASE );
+    eeprom_prompt(EEPROM_STEP_READ_ADDR);
+}
+
+static void eeprom_read_addr(uint16_t addr_read)
+{
+    __xdata uint8_t byte_read1 = 0;
+
     if(addr_read >= 0 && addr_read <= ADDR_MAX){}
     else{
         printf("\r\nInvalid Adress Range!!\r\n Address has to be between 0x000 to 0x7FF\r\n");
+        eeprom_done();
         return;
     }
     printf("\r\n");
@@ -69,51 +110,117 @@ void EEPROM_READ(void)
     byte_read1 = I2C_EEPROM_READ(addr_read);
     printf_tiny("\r\nReading from EEPROM Completed!!\r\n");
     printf("\r\nData = %x present at Location = 0%x \r\n",byte_read1,addr_read);
-
+    eeprom_done();
 }
 
 void EEPROM_DUMP(void)
 {
-    __xdata uint16_t start_addr = 0;
     printf_tiny("\r\nEnter Start Address for HEX Dump\r\n");
-    start_addr = INPUT_PARSING(HEX_BASE);
+    eeprom_prompt(EEPROM_STEP_DUMP_START);
+}
 
+static void eeprom_dump_start(uint16_t start_addr)
+{
     if(start_addr >= 0 && start_addr <= ADDR_MAX){}
     else{
         printf("\r\nInvalid Start Address Range!!\r\n Address has to be between 0x000 to 0x7FF\r\n");
+        eeprom_done();
         return;
     }
-
-    __xdata uint16_t end_addr = 0;
+    eeprom_addr = start_addr;
 
     printf_tiny("\r\nEnter End Address for HEX Dump\r\n");
-    end_addr = INPUT_PARSING(HEX_BASE);
+    eeprom_prompt(EEPROM_STEP_DUMP_END);
+}
 
+static void eeprom_dump_end(uint16_t end_addr)
+{
     if(end_addr >= 0 && end_addr <= ADDR_MAX){}
     else{
         printf("\r\nInvalid End Address Range!!\r\n Address has to be between 0x000 to 0x7FF\r\n");
+        eeprom_done();
         return;
     }
+    eeprom_end_addr = end_addr;
 
     printf_tiny("\r\nI2C EEPROM DUMP!!\r\n");
+    eeprom_step = EEPROM_STEP_DUMPING;
+    sched_post(eeprom_dump_task);
+}
+
+// Prints one row of the dump per run, so the expander is served in between
+static void eeprom_dump_task_fn(void)
+{
+    __xdata uint8_t count = 0, data_byte = 0;
 
-    __xdata uint8_t count = 0, i = 0, temp_storage = 0, data_byte = 0;
-    while (start_addr <= end_addr) {
-        if (count % DIVIDE_BY_16 == 0) {
+    if (eeprom_step != EEPROM_STEP_DUMPING) {
+        return;
+    }
+    while (eeprom_addr <= eeprom_end_addr && count < DIVIDE_BY_16) {
+        if (count == 0) {
             putchar('\n');
             putchar('\r');
-            print_hex_number(start_addr, 3);
+            print_hex_number(eeprom_addr, 3);
             putchar(':');
         }
         putchar(ASCII_SPACE);
-        data_byte = I2C_EEPROM_READ(start_addr);
+        data_byte = I2C_EEPROM_READ(eeprom_addr);
         print_hex_number(data_byte, 2);
 
-        start_addr++;
+        eeprom_addr++;
         count++;
     }
+    if (eeprom_addr <= eeprom_end_addr) {
+        sched_post(eeprom_dump_task);   // next row on the next run
+        return;
+    }
     printf("\r\n");
+    eeprom_done();
+}
+
+void EEPROM_INIT(void)
+{
+    eeprom_dump_task = sched_add("dump", eeprom_dump_task_fn, 0);
 }
 
+uint8_t EEPROM_BUSY(void)
+{
+    return eeprom_step != EEPROM_STEP_NONE;
+}
+
+uint8_t EEPROM_DUMPING(void)
+{
+    return eeprom_step == EEPROM_STEP_DUMPING;
+}
 
+uint8_t EEPROM_KEY(char ch)
+{
+    uint16_t value;
 
+    if (eeprom_step == EEPROM_STEP_NONE || eeprom_step == EEPROM_STEP_DUMPING) {
+        return 0;                   // not a prompt, the key is a command
+    }
+    if (INPUT_FEED(ch) != INPUT_DONE) {
+        return 1;
+    }
+
+    value = INPUT_VALUE(HEX_BASE);
+    switch (eeprom_step) {
+        case EEPROM_STEP_WRITE_DATA:
+            eeprom_write_data(value);
+            break;
+        case EEPROM_STEP_WRITE_ADDR:
+            eeprom_write_addr(value);
+            break;
+        case EEPROM_STEP_READ_ADDR:
+            eeprom_read_addr(value);
+            break;
+        case EEPROM_STEP_DUMP_START:
+            eeprom_dump_start(value);
+            break;
+        default:
+            eeprom_dump_end(value);
+            break;
+    }
+    return 1;
+}
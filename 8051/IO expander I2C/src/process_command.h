@@ -2,6 +2,25 @@
 #ifndef _COMM_PROCC_
 #define _COMM_PROCC_
 
+#include <stdint.h>
+
+/*
+ * The commands below only print their first prompt. The console task hands
+ * every following key to EEPROM_KEY until the operation ends, and a dump
+ * prints one row per run of its own task.
+ */
+
+void EEPROM_INIT(void);
+
+
+uint8_t EEPROM_BUSY(void);
+
+
+uint8_t EEPROM_DUMPING(void);
+
+
+uint8_t EEPROM_KEY(char ch);
+
 
 void EEPROM_READ(void);
 
@@ -4,6 +4,10 @@
  *
  * This file provides functions to initialize the UART, send/receive characters, and perform
  * hexadecimal and integer conversions. It also includes a robust input parsing function.
+ *
+ * Both directions are interrupt driven, so no task waits on the line: received
+ * bytes are queued for the console task, and putchar only waits for the
+ * byte before it.
  */
 
 #include <stdbool.h>
@@ -16,6 +20,8 @@
 #include <mcs51reg.h>
 #include <mcs51/8051.h>
 #include"driver.h"
+#include "sched.h"
+#include "uart.h"
 
 
 #define MAX_DIGITS 20       // Maximum number of digits in user input
@@ -23,37 +29,74 @@
 #define BACKSPACE 8         // ASCII code for backspace
 #define SPACE 32            // ASCII code for space
 
+// Console bytes from the serial ISR to the console task
+RING_DEFINE(uart_rx, uint8_t, UART_RX_SIZE, __xdata);
+
+__data uint8_t uart_rx_task = SCHED_NO_TASK;
+volatile __data uint8_t uart_tx_busy = 0;
+
+// Digits typed so far at a number prompt
+__xdata uint8_t input_digits[MAX_DIGITS];
+__xdata uint8_t input_digit_count;
+
+void uart_isr(void) __interrupt(4)
+{
+    if (RI) {
+        RI = 0;
+        if (!RING_FULL(uart_rx)) {
+            RING_PUT(uart_rx, SBUF);
+            if (uart_rx_task != SCHED_NO_TASK) {
+                SCHED_POST_FROM_ISR(uart_rx_task);
+            }
+        }
+    }
+
+    if (TI) {
+        TI = 0;
+        uart_tx_busy = 0;
+    }
+}
 
 /**
  * @brief Receives a single character via UART.
  * 
- * Waits until a character is received, clears the receive interrupt flag, 
- * and returns the received character.
+ * Waits until the serial ISR has queued a character and returns it. The
+ * console task reads uart_rx directly instead, so it never waits.
  * 
  * @return int The received character.
  */
 int getchar (void)
 {
-    while (!RI); //Wait till the Character is received
-	RI = 0;			// Clear the RI flag
-	return SBUF;  	// Return the Character
+    uint8_t c;
+
+    while (RING_EMPTY(uart_rx)); //Wait till the Character is received
+    RING_GET(uart_rx, c);
+    return c;           // Return the Character
 }
 
 
 /**
  * @brief Transmits a single character via UART.
  * 
- * Waits until the transmitter is ready, writes the character to the UART buffer,
- * and clears the transmit interrupt flag.
+ * Waits until the serial ISR has finished the previous byte, then writes the
+ * character to the UART buffer. Needs the serial interrupt enabled.
  * 
  * @param c The character to transmit.
  * @return int The transmitted character.
  */
 int putchar (int c)
 {
-    while(!TI); //Wait till the Transmitter is ready
+    // Test and claim the transmitter with the ISR held off
+    while (1) {
+        ES = 0;
+        if (!uart_tx_busy) {
+            break;
+        }
+        ES = 1;
+    }
+    uart_tx_busy = 1;
     SBUF = c; //write character to SBUF
-    TI = 0; //Clear the TI flag
+    ES = 1;
     return c;
 }
 
@@ -62,7 +105,7 @@ int putchar (int c)
  * @brief Initializes the UART for 9600 baud communication.
  * 
  * Configures Timer 1 in Mode 2 (8-bit auto-reload) and UART in Mode 1 (8-bit UART).
- * Enables interrupts and prepares for data transmission.
+ * Enables the serial interrupt that both directions run on.
  */
 void initialize_UART(void)
 {
@@ -70,9 +113,11 @@ void initialize_UART(void)
     SCON = 0x50;    // Set UART to Mode 1 (8-bit UART), REN enabled
     TH1 = 0xFD;     // Load TH1 for 9600 baud rate (for 11.0592 MHz clock)
     TR1 = 1;        // Start Timer 1
-    ES = 1;         // Enable UART interrupt
+    RI = 0;
+    TI = 0;
+    uart_tx_busy = 0;
+    ES = 1;         // Enable the serial interrupt
     EA = 1;         // Enable global interrupt
-    TI = 1;         // Set TI to indicate ready for transmission
 }
 
 
@@ -110,44 +155,56 @@ uint8_t CONVERT_CHAR_INT(uint8_t ch)
 }
 
 
+void INPUT_START(void)
+{
+    input_digit_count = 0;
+}
+
+
 /**
- * @brief Parses user input as a number in a given base.
+ * @brief Adds one typed character to the number at the prompt.
  * 
- * Accepts characters until a carriage return is received. Supports hexadecimal input
- * and handles backspace for corrections. Converts the input string to an integer.
+ * Accepts hex digits and handles backspace for corrections, echoing both.
+ * Digits past MAX_DIGITS are ignored.
  * 
- * @param base The base (e.g., 10 for decimal, 16 for hexadecimal) of the input.
- * @return uint16_t The parsed number.
+ * @param current_char The character.
+ * @return uint8_t INPUT_DONE once a carriage return ends the number, else INPUT_MORE.
  */
-uint16_t INPUT_PARSING(uint8_t base)
+uint8_t INPUT_FEED(uint8_t current_char)
 {
-    uint16_t number = 0;
-    uint16_t digits[MAX_DIGITS] = {0};
-    uint16_t digit_count = 0;
-    uint16_t i = 0;
-    uint16_t current_char = 0;
-
-    while (current_char != CARRIAGE_RETURN) {   // Loop until the input is complete.
-        current_char = getchar();               // Read the next character.
-
-        if (((current_char >= '0') && (current_char <= '9')) || ((current_char >= 'a') && (current_char <= 'f')) ||
-            ((current_char >= 'A') && (current_char <= 'F'))){
+    if (((current_char >= '0') && (current_char <= '9')) || ((current_char >= 'a') && (current_char <= 'f')) ||
+        ((current_char >= 'A') && (current_char <= 'F'))){
+        if (input_digit_count < MAX_DIGITS) {
             putchar(current_char);                              // Echo the character back to the user.
-            digits[digit_count++] = CONVERT_CHAR_INT(current_char);
-        } else if (current_char == BACKSPACE){
-            if (digit_count > 0) {
-                putchar(BACKSPACE); // Move the cursor back one position.
-                putchar(SPACE);     // Print a space to overwrite the previous digit.
-                putchar(BACKSPACE); // Move the cursor back one position again.
-                digit_count--;      // Decrement the digit count.
-            }
+            input_digits[input_digit_count++] = CONVERT_CHAR_INT(current_char);
+        }
+    } else if (current_char == BACKSPACE){
+        if (input_digit_count > 0) {
+            putchar(BACKSPACE); // Move the cursor back one position.
+            putchar(SPACE);     // Print a space to overwrite the previous digit.
+            putchar(BACKSPACE); // Move the cursor back one position again.
+            input_digit_count--;      // Decrement the digit count.
         }
     }
+    return (current_char == CARRIAGE_RETURN) ? INPUT_DONE : INPUT_MORE;
+}
+
+
+/**
+ * @brief Converts the digits typed at the prompt to a number.
+ * 
+ * @param base The base (e.g., 10 for decimal, 16 for hexadecimal) of the input.
+ * @return uint16_t The parsed number.
+ */
+uint16_t INPUT_VALUE(uint8_t base)
+{
+    uint16_t number = 0;
+    uint8_t i = 0;
 
-    for(i = 0; i < digit_count; i++) // Iterate over the digits.
+    for(i = 0; i < input_digit_count; i++) // Iterate over the digits.
     {
         number *= base;             // Multiply the current value of number by the base.
-        number += digits[i];        // Add the current digit to number.
+        number += input_digits[i];  // Add the current digit to number.
     }
     return number;
 }
@@ -1,6 +1,28 @@
 #ifndef _UART_H_
 #define _UART_H_
 
+#include <stdint.h>
+#include "ring.h"
+
+/*
+ * The serial ISR queues received bytes in uart_rx and posts uart_rx_task;
+ * putchar waits only for the byte before it. Numbers are typed a character
+ * at a time: INPUT_START, then INPUT_FEED per character until INPUT_DONE,
+ * then INPUT_VALUE.
+ */
+#define UART_RX_SIZE        16
+
+#define INPUT_MORE          0
+#define INPUT_DONE          1
+
+RING_EXTERN(uart_rx, uint8_t, UART_RX_SIZE, __xdata);
+
+// Task posted when a byte arrives, SCHED_NO_TASK for none
+extern __data uint8_t uart_rx_task;
+
+// Serial ISR; the prototype must stay visible to main.c for the vector table
+void uart_isr(void) __interrupt(4);
+
 int getchar (void);
 
 int putchar (int c);
@@ -14,7 +36,13 @@ uint8_t CONVERT_CHAR_INT(uint8_t ch);
 char int_to_char(int num);
 
 
-uint16_t INPUT_PARSING(uint8_t number_base);
+void INPUT_START(void);
+
+
+uint8_t INPUT_FEED(uint8_t current_char);
+
+
+uint16_t INPUT_VALUE(uint8_t number_base);
 
 
 void print_hex_number(uint32_t num, uint8_t width);
@@ -0,0 +1,46 @@
+// Author: Lokesh Senthil Kumar
+// app_config.h file sets this program's options for the shared modules in ../common
+
+#ifndef _APP_CONFIG_H_
+#define _APP_CONFIG_H_
+
+/* ---- irq.h: interrupt sources; costs are estimates, see irq.h ---- */
+
+/* Longest stretch the foreground keeps a source masked */
+#define IRQ_CRITICAL_US     10
+
+/* Timer 0, stopwatch: it reloads in the handler, so waiting adds drift */
+#define IRQ_TIMER0_COST_US      40
+#define IRQ_TIMER0_BUDGET_US    100
+#define IRQ_TIMER0_MEASURED     1
+
+/* PCA, frequency counter: re-arms the capture edge before the next edge */
+#define IRQ_PCA_COST_US         150
+#define IRQ_PCA_BUDGET_US       300
+#define IRQ_PCA_MEASURED        1
+
+/* Serial, console: SBUF must be read before the next byte (1 ms) */
+#define IRQ_SERIAL_COST_US      15
+#define IRQ_SERIAL_BUDGET_US    500
+#define IRQ_SERIAL_MEASURED     0
+
+/* Timer 2, 1 ms tick: the LCD write is deferred, a late tick only shifts it */
+#define IRQ_TIMER2_COST_US      20
+#define IRQ_TIMER2_BUDGET_US    800
+#define IRQ_TIMER2_MEASURED     1
+
+#define IRQ_LIST(X, arg)    X(TIMER0, arg) X(PCA, arg) X(SERIAL, arg) X(TIMER2, arg)
+
+/* ---- defer.h: deferred handlers, highest priority first ---- */
+
+#define DEFER_LCD           0       // write the next queued LCD byte
+#define DEFER_FREQ          1       // report a finished frequency gate
+#define DEFER_COUNT         2
+
+/* ---- timebase.c: work on every 1 ms tick, must call nothing ---- */
+
+// Hand the next queued LCD write to the main loop
+#define TIMEBASE_TICK_INCLUDE   "lcd.h"
+#define TIMEBASE_TICK()         LCD_TICK()
+
+#endif // _APP_CONFIG_H_
@@ -0,0 +1,202 @@
+// Author: Lokesh Senthil Kumar
+// clock.c file keeps the MM:SS.t stopwatch in BCD and draws it on the LCD
+
+#include <stdint.h>
+#include <at89c51ed2.h>
+#include <mcs51/8051.h>
+
+#include "lcd.h"
+#include "swtimer.h"
+#include "irq.h"
+#include "clock.h"
+
+// Time in BCD, written only by the ISR and clock_reset. It lives in the
+// persistent NVRAM region so a reset does not lose the stopwatch.
+typedef struct {
+    uint16_t magic;
+    uint8_t tenths;         // 0 to 9
+    uint8_t seconds;        // 0x00 to 0x59
+    uint8_t minutes;        // 0x00 to 0x59
+} clock_state_t;
+
+volatile __xdata __at(CLOCK_NV_ADDR) clock_state_t clock_nv;
+
+#define clock_tenths  clock_nv.tenths
+#define clock_seconds clock_nv.seconds
+#define clock_minutes clock_nv.minutes
+
+// Set by the ISR when the time moved, cleared by clock_render
+volatile __data uint8_t clock_changed = 1;
+
+// What is on the panel, 0xFF forces a digit to be drawn
+uint8_t clock_drawn_tenths  = 0xFF;
+uint8_t clock_drawn_seconds = 0xFF;
+uint8_t clock_drawn_minutes = 0xFF;
+uint8_t clock_drawn_marks   = 0;
+
+// Blinks the colon while paused
+__xdata swtimer_t clock_blink_timer;
+uint8_t clock_blink_on = 0;
+
+// A packed BCD value from 0x00 to 0x59
+static uint8_t bcd_valid_60(uint8_t value)
+{
+    return (value & 0x0F) <= 0x09 && value < 0x60;
+}
+
+// Add one to a packed BCD byte, wrapped is set when it goes from 0x59 to
+// 0x00. A macro so the ISR calls nothing and can keep its own register bank.
+#define BCD_INC_60(value, wrapped) do {         \
+        uint8_t v_ = (value);                   \
+        if ((v_ & 0x0F) == 0x09) {              \
+            v_ = (v_ & 0xF0) + 0x10;            \
+        } else {                                \
+            v_++;                               \
+        }                                       \
+        (wrapped) = (v_ == 0x60);               \
+        (value) = (wrapped) ? 0x00 : v_;        \
+    } while (0)
+
+void clock_ISR(void) __interrupt(1) __using(IRQ_BANK(TIMER0))
+{
+    static __data uint8_t ticks = 0;
+    uint8_t wrapped;
+
+    IRQ_MEASURE_TIMER0();
+    TH0 = CLOCK_RELOAD_H;   // Reload first so the ISR time does not add drift
+    TL0 = CLOCK_RELOAD_L;
+    TF0 = 0;
+
+    if (++ticks < CLOCK_TICKS_PER_TENTH) {
+        return;
+    }
+    ticks = 0;
+    P1_1 = P1_1 ^ 1;        // Toggle pin P1_1 every tenth
+
+    if (++clock_tenths == 10) {
+        clock_tenths = 0;
+        BCD_INC_60(clock_seconds, wrapped);
+        if (wrapped) {
+            BCD_INC_60(clock_minutes, wrapped);
+        }
+    }
+    clock_changed = 1;
+}
+
+void clock_init(void)
+{
+    // Keep the time from before the reset if it survived intact
+    if (clock_nv.magic != CLOCK_NV_MAGIC || clock_tenths > 9 ||
+        !bcd_valid_60(clock_seconds) || !bcd_valid_60(clock_minutes)) {
+        clock_reset();
+    }
+    clock_changed = 1;
+
+    TCON = TCON & (~0x30);  // Stop Timer 0 and clear its overflow flag
+    TMOD = (TMOD & 0xF0) | 0x01;    // Timer 0 in 16-bit mode
+    TH0 = CLOCK_RELOAD_H;
+    TL0 = CLOCK_RELOAD_L;
+    ET0 = 1;
+    EA = 1;
+    TR0 = 1;
+}
+
+void clock_reset(void)
+{
+    uint8_t et0 = ET0;
+
+    ET0 = 0;                // The three bytes must change together
+    clock_tenths = 0;
+    clock_seconds = 0x00;
+    clock_minutes = 0x00;
+    clock_nv.magic = CLOCK_NV_MAGIC;
+    clock_changed = 1;
+    ET0 = et0;
+}
+
+// Timer callback: show or hide the colon
+static void clock_blink(uint8_t arg)
+{
+    (void)arg;
+    clock_blink_on ^= 1;
+    lcd_fb_putch(CLOCK_LCD_ADDR + 2, clock_blink_on ? ' ' : ':');
+    lcd_flush();
+}
+
+void clock_pause(void)
+{
+    if (!TR0) {
+        return;             // Already paused, keep the blink phase
+    }
+    TR0 = 0;
+    clock_blink_on = 0;
+    swtimer_start(&clock_blink_timer, CLOCK_BLINK_MS, CLOCK_BLINK_MS, clock_blink, 0);
+}
+
+void clock_resume(void)
+{
+    swtimer_stop(&clock_blink_timer);
+    clock_blink_on = 0;
+    clock_drawn_marks = 0;  // put the colon back, whatever the blink left
+    clock_changed = 1;
+    TR0 = 1;
+}
+
+void clock_invalidate(void)
+{
+    clock_drawn_tenths = 0xFF;
+    clock_drawn_seconds = 0xFF;
+    clock_drawn_minutes = 0xFF;
+    clock_drawn_marks = 0;
+    clock_changed = 1;
+}
+
+void clock_render(void)
+{
+    uint8_t tenths, seconds, minutes, diff;
+
+    if (!clock_changed) {
+        return;
+    }
+
+    // Take one consistent snapshot of the counters
+    ET0 = 0;
+    tenths = clock_tenths;
+    seconds = clock_seconds;
+    minutes = clock_minutes;
+    clock_changed = 0;
+    ET0 = 1;
+
+    // Layout: M M : S S . t at 0x59 to 0x5F
+    diff = minutes ^ clock_drawn_minutes;
+    if (diff & 0xF0) {
+        lcd_fb_putch(CLOCK_LCD_ADDR + 0, '0' + (minutes >> 4));
+    }
+    if (diff & 0x0F) {
+        lcd_fb_putch(CLOCK_LCD_ADDR + 1, '0' + (minutes & 0x0F));
+    }
+
+    diff = seconds ^ clock_drawn_seconds;
+    if (diff & 0xF0) {
+        lcd_fb_putch(CLOCK_LCD_ADDR + 3, '0' + (seconds >> 4));
+    }
+    if (diff & 0x0F) {
+        lcd_fb_putch(CLOCK_LCD_ADDR + 4, '0' + (seconds & 0x0F));
+    }
+
+    if (tenths != clock_drawn_tenths) {
+        lcd_fb_putch(CLOCK_LCD_ADDR + 6, '0' + tenths);
+    }
+
+    if (!clock_drawn_marks) {
+        lcd_fb_putch(CLOCK_LCD_ADDR + 2, ':');
+        lcd_fb_putch(CLOCK_LCD_ADDR + 5, '.');
+        clock_drawn_marks = 1;
+    }
+
+    clock_drawn_minutes = minutes;
+    clock_drawn_seconds = seconds;
+    clock_drawn_tenths = tenths;
+
+    lcd_flush();            // Only the changed cells reach the panel
+}
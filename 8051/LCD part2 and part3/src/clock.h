@@ -0,0 +1,75 @@
+// Author: Lokesh Senthil Kumar
+// clock.h file declares the MM:SS.t stopwatch kept by Timer 0
+
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+#include <stdint.h>
+#include "startup.h"
+#include "irq.h"
+
+/* Timer 0 reload for 50 ms: 65536 - 46083 machine cycles = 0x4BFD */
+#define CLOCK_RELOAD_H      0x4B
+#define CLOCK_RELOAD_L      0xFD
+#define CLOCK_TICKS_PER_TENTH 2
+
+/* Time kept in the persistent NVRAM region (startup.h) across resets */
+#define CLOCK_NV_ADDR       PERSIST_ADDR
+#define CLOCK_NV_MAGIC      0xC10C
+
+/* Where MM:SS.t is drawn, the end of row 3 */
+#define CLOCK_LCD_ADDR      0x59
+
+/* The colon blinks at this half period while the stopwatch is paused */
+#define CLOCK_BLINK_MS      500
+
+/**
+ * @brief   Timer 0 ISR, advances the BCD counters only.
+ * @details The LCD is never touched here and nothing is called, so it runs
+ *          on its own register bank. The prototype must stay visible to
+ *          main.c for the vector table.
+ */
+void clock_ISR(void) __interrupt(1) __using(IRQ_BANK(TIMER0));
+
+/**
+ * @brief   Starts Timer 0, continuing from the time saved in NVRAM.
+ * @details The time is zeroed if the saved copy is missing or damaged.
+ * @return  void
+ */
+void clock_init(void);
+
+/**
+ * @brief   Sets the time back to 00:00.0.
+ * @return  void
+ */
+void clock_reset(void);
+
+/**
+ * @brief   Stops the time and blinks the colon on a software timer.
+ * @details Does nothing when the clock is already paused.
+ * @return  void
+ */
+void clock_pause(void);
+
+/**
+ * @brief   Lets the time run again and stops the blinking.
+ * @return  void
+ */
+void clock_resume(void);
+
+/**
+ * @brief   Makes the next clock_render draw every character again.
+ * @details Call after the panel or its shadow buffer has been cleared.
+ * @return  void
+ */
+void clock_invalidate(void);
+
+/**
+ * @brief   Draws the digits that changed since the last frame.
+ * @details Called from the main loop. Does nothing until the ISR has
+ *          advanced the time.
+ * @return  void
+ */
+void clock_render(void);
+
+#endif // _CLOCK_H_
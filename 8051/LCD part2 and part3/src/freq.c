@@ -0,0 +1,266 @@
+// Author: Lokesh Senthil Kumar
+// freq.c file measures frequency, period and duty cycle with PCA capture
+
+#include <stdint.h>
+#include <ctype.h>
+#include <stdio.h>
+#include "at89c51ed2.h"
+
+#include "uart.h"
+#include "lcd.h"
+#include "freq.h"
+#include "defer.h"
+#include "irq.h"
+
+/* One gate's worth of measurements, handed from the ISR to the main loop */
+typedef struct {
+    uint16_t periods;       // Complete periods seen in the gate
+    uint32_t period_sum;    // Sum of the periods in PCA counts
+    uint32_t high_sum;      // Sum of the high times of the same periods
+    uint32_t period_min;
+    uint32_t period_max;
+} freq_result_t;
+
+// Upper 16 bits of the 32-bit PCA time base
+volatile __data uint16_t freq_overflows = 0;
+
+/* Accumulators owned by the ISR, in internal RAM to keep MOVX out of it */
+__idata freq_result_t freq_acc;
+__data uint32_t freq_last_rise;
+__data uint32_t freq_pending_high;
+__data uint8_t freq_have_rise;
+__data uint8_t freq_edge_rising;
+__data uint8_t freq_gate_count;
+
+/* Handshake with the main loop */
+__xdata freq_result_t freq_result;
+volatile __data uint8_t freq_ready = 0;
+
+/* Settings */
+__data uint8_t freq_gate = FREQ_GATE_1S;
+uint8_t freq_single_shot = 0;
+uint8_t freq_output = FREQ_OUT_UART;
+volatile uint8_t freq_active = 0;
+
+// Start a new gate, keeping the last edge so periods carry across gates.
+// A macro so the ISR calls nothing and can keep its own register bank.
+#define FREQ_RESET_ACC() do {                   \
+        freq_acc.periods = 0;                   \
+        freq_acc.period_sum = 0;                \
+        freq_acc.high_sum = 0;                  \
+        freq_acc.period_min = 0xFFFFFFFF;       \
+        freq_acc.period_max = 0;                \
+        freq_gate_count = 0;                    \
+    } while (0)
+
+void pca_isr(void) __interrupt(6) __using(IRQ_BANK(PCA))
+{
+#ifdef IRQ_MEASURE
+    if (CF) {                   // CH:CL counts on from 0 after the overflow
+        uint16_t counts = CL | ((uint16_t)CH << 8);
+
+        // 3 counts per machine cycle; x/3 by shifts, a division would be a call
+        IRQ_NOTE_LATENCY(IRQ_PCA_VECTOR, (counts >> 2) + (counts >> 4) + (counts >> 6) + (counts >> 8));
+    }
+#endif
+    if (CCF1) {
+        uint8_t low = CCAP1L;
+        uint8_t high = CCAP1H;
+        __data uint16_t ext = freq_overflows;   // ISR locals would be in XRAM
+        __data uint32_t stamp;
+        __data uint32_t period;
+
+        CCF1 = 0;
+
+        // An overflow still pending behind a small capture value happened
+        // before the edge, so it belongs to this timestamp
+        if (CF && !(high & 0x80)) {
+            ext++;
+        }
+        stamp = ((uint32_t)ext << 16) | ((uint16_t)high << 8) | low;
+
+        if (freq_edge_rising) {
+            if (freq_have_rise) {
+                period = stamp - freq_last_rise;
+                freq_acc.periods++;
+                freq_acc.period_sum += period;
+                freq_acc.high_sum += freq_pending_high;
+                if (period < freq_acc.period_min) {
+                    freq_acc.period_min = period;
+                }
+                if (period > freq_acc.period_max) {
+                    freq_acc.period_max = period;
+                }
+            }
+            freq_last_rise = stamp;
+            freq_pending_high = 0;
+            freq_have_rise = 1;
+            freq_edge_rising = 0;
+            CCAPM1 = FREQ_CAPTURE_FALL;
+        } else {
+            if (freq_have_rise) {
+                freq_pending_high = stamp - freq_last_rise;
+            }
+            freq_edge_rising = 1;
+            CCAPM1 = FREQ_CAPTURE_RISE;
+        }
+    }
+
+    if (CF) {
+        CF = 0;
+        freq_overflows++;
+
+        if (++freq_gate_count >= freq_gate) {
+            if (!freq_ready) {      // Drop the gate if the last one is unread
+                freq_result.periods = freq_acc.periods;
+                freq_result.period_sum = freq_acc.period_sum;
+                freq_result.high_sum = freq_acc.high_sum;
+                freq_result.period_min = freq_acc.period_min;
+                freq_result.period_max = freq_acc.period_max;
+                freq_ready = 1;
+                DEFER_RAISE(DEFER_FREQ);
+            }
+            FREQ_RESET_ACC();
+        }
+    }
+}
+
+// (a * mul) / div without overflowing 32 bits, for (div - 1) * mul < 2^32
+static uint32_t muldiv(uint32_t a, uint16_t mul, uint16_t div)
+{
+    return (a / div) * mul + ((a % div) * mul) / div;
+}
+
+static void freq_start(void)
+{
+    CR = 0;
+    CMOD = FREQ_CMOD;
+    CL = 0;
+    CH = 0;
+
+    freq_overflows = 0;
+    freq_have_rise = 0;
+    freq_edge_rising = 1;
+    freq_pending_high = 0;
+    FREQ_RESET_ACC();
+    freq_ready = 0;
+    freq_active = 1;
+
+    CCF1 = 0;
+    CF = 0;
+    CCAPM1 = FREQ_CAPTURE_RISE;
+    IEN0 |= FREQ_IEN0_EC;
+    CR = 1;
+}
+
+void freq_stop(void)
+{
+    IEN0 &= ~FREQ_IEN0_EC;
+    CR = 0;
+    CCAPM1 = 0;
+    CCF1 = 0;
+    CF = 0;
+    freq_active = 0;
+}
+
+uint8_t freq_running(void)
+{
+    return freq_active;
+}
+
+uint8_t freq_on_lcd(void)
+{
+    return freq_active && freq_output == FREQ_OUT_LCD;
+}
+
+// Setup question being answered: 0 gate time, 1 mode, 2 output
+__xdata uint8_t freq_setup_step;
+
+static uint8_t freq_setup_key(char c)
+{
+    switch (freq_setup_step++) {
+    case 0:
+        freq_gate = (c == '1') ? FREQ_GATE_100MS : FREQ_GATE_1S;
+        printf(" \n\rMode: [S] Single shot  [C] Continuous\r\n");
+        return UART_READ_MORE;
+
+    case 1:
+        freq_single_shot = (toupper(c) == 'S');
+        printf(" \n\rOutput: [U] UART  [L] LCD\r\n");
+        return UART_READ_MORE;
+
+    default:
+        freq_output = (toupper(c) == 'L') ? FREQ_OUT_LCD : FREQ_OUT_UART;
+        printf(" \n\rMeasuring on P1.4 (CEX1), press K to stop\r\n");
+        freq_start();
+        return UART_READ_DONE;
+    }
+}
+
+void handler_freq_counter(void)
+{
+    printf(" \n\rGate time: [1] 0.1 s  [2] 1 s\r\n");
+    freq_setup_step = 0;
+    uart_read_with(freq_setup_key);
+}
+
+void freq_poll(void)
+{
+    __xdata char line[17];
+    uint32_t period16, freq_dhz, period_x10, min_x10, max_x10;
+    uint32_t period_sum, high_sum;
+    uint16_t duty;
+
+    if (!freq_active || !freq_ready) {
+        return;
+    }
+
+    if (freq_result.periods == 0) {
+        if (freq_output == FREQ_OUT_LCD) {
+            sprintf(line, "No signal       ");
+        } else {
+            printf("No signal\r\n");
+        }
+    } else {
+        // Mean period in 1/16 counts, then 442368000 / period16 = f in 0.1 Hz
+        period16 = (freq_result.period_sum << 4) / freq_result.periods;
+        freq_dhz = (FREQ_PCA_CLOCK * 160) / period16;
+
+        // Counts to 0.1 us: x 100000 / 27648 = x 3125 / 864
+        period_x10 = muldiv(period16, 3125, 864 * 16);
+        min_x10 = muldiv(freq_result.period_min, 3125, 864);
+        max_x10 = muldiv(freq_result.period_max, 3125, 864);
+
+        // Duty cycle in 0.1 %, scaled so the product stays in 32 bits
+        period_sum = freq_result.period_sum;
+        high_sum = freq_result.high_sum;
+        while (period_sum > 0x003FFFFF) {
+            period_sum >>= 1;
+            high_sum >>= 1;
+        }
+        duty = (uint16_t)((high_sum * 1000) / period_sum);
+
+        if (freq_output == FREQ_OUT_LCD) {
+            sprintf(line, "%5lu.%luHz %2u.%u%% ", freq_dhz / 10, freq_dhz % 10,
+                    duty / 10, duty % 10);
+        } else {
+            printf("F=%lu.%lu Hz  T=%lu.%lu us  D=%u.%u %%  Tmin=%lu.%lu us  Tmax=%lu.%lu us  Jitter=%lu.%lu us\r\n",
+                   freq_dhz / 10, freq_dhz % 10,
+                   period_x10 / 10, period_x10 % 10,
+                   duty / 10, duty % 10,
+                   min_x10 / 10, min_x10 % 10,
+                   max_x10 / 10, max_x10 % 10,
+                   (max_x10 - min_x10) / 10, (max_x10 - min_x10) % 10);
+        }
+    }
+
+    if (freq_output == FREQ_OUT_LCD) {
+        lcd_fb_putstr(FREQ_LCD_ADDR, line);     // only changed digits are queued
+        lcd_flush();
+    }
+
+    freq_ready = 0;
+    if (freq_single_shot) {
+        freq_stop();
+    }
+}
@@ -0,0 +1,69 @@
+// Author: Lokesh Senthil Kumar
+// freq.h file declares the PCA capture frequency and period counter
+
+#ifndef _FREQ_H_
+#define _FREQ_H_
+
+#include <stdint.h>
+#include "irq.h"
+
+/*
+ * The input signal goes to CEX1 (P1.4). PCA module 1 captures alternately on
+ * rising and falling edges; the PCA counts at Fosc/4 (2.7648 MHz, 362 ns) and
+ * the overflow interrupt extends CH:CL to 32 bits. The ISR needs two entries
+ * per period, so inputs up to about 2 kHz can be measured.
+ */
+#define FREQ_PCA_CLOCK      2764800UL   // Fosc/4
+#define FREQ_CMOD           0x03        // CPS1:0 = 01 (Fosc/4) | ECF
+#define FREQ_CAPTURE_RISE   0x21        // CAPP | ECCF
+#define FREQ_CAPTURE_FALL   0x11        // CAPN | ECCF
+#define FREQ_IEN0_EC        0x40        // PCA interrupt enable in IEN0
+
+/* Gate times in PCA overflows of 65536 counts (23.7 ms each) */
+#define FREQ_GATE_100MS     4           // 94.8 ms
+#define FREQ_GATE_1S        42          // 995 ms
+
+/* Result destinations */
+#define FREQ_OUT_UART       0
+#define FREQ_OUT_LCD        1
+
+/* LCD row used for the readout; the clock keeps row 3 */
+#define FREQ_LCD_ADDR       0x10
+
+/**
+ * @brief   PCA interrupt for the edge captures and the counter overflow.
+ * @details The prototype must stay visible to main.c for the vector table.
+ */
+void pca_isr(void) __interrupt(6) __using(IRQ_BANK(PCA));
+
+/**
+ * @brief   Asks for gate time, mode and output and starts measuring.
+ * @details Pressing 'K' again while the counter runs stops it.
+ */
+void handler_freq_counter(void);
+
+/**
+ * @brief   Prints or displays a finished gate result.
+ * @details The DEFER_FREQ handler, raised by the PCA interrupt at the end of
+ *          a gate; stops the counter after one result in single-shot mode.
+ */
+void freq_poll(void);
+
+/**
+ * @brief   Reports whether the counter is running.
+ * @return  1 while measuring, 0 when stopped.
+ */
+uint8_t freq_running(void);
+
+/**
+ * @brief   Reports whether the readout at FREQ_LCD_ADDR is in use.
+ * @return  1 while measuring with LCD output, otherwise 0.
+ */
+uint8_t freq_on_lcd(void);
+
+/**
+ * @brief   Stops the PCA and the counter.
+ */
+void freq_stop(void);
+
+#endif // _FREQ_H_
@@ -0,0 +1,150 @@
+// Author: Lokesh Senthil Kumar
+// glyph.c file keeps named glyphs in the 8 CGRAM slots with LRU eviction
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lcd.h"
+#include "glyph.h"
+
+static __code uint8_t glyph_builtin[GLYPH_BUILTIN_COUNT][8] = {
+    {0x00, 0x00, 0x0F, 0x08, 0x08, 0x09, 0x09, 0x09},   // CU top left
+    {0x00, 0x00, 0x18, 0x00, 0x00, 0x02, 0x02, 0x02},   // CU top right
+    {0x09, 0x09, 0x09, 0x0F, 0x01, 0x01, 0x00, 0x00},   // CU bottom left
+    {0x02, 0x02, 0x02, 0x1A, 0x02, 0x1E, 0x00, 0x00},   // CU bottom right
+    {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10},   // bar 1
+    {0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18},   // bar 2
+    {0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C},   // bar 3
+    {0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E},   // bar 4
+    {0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},   // bar 5
+    {0x04, 0x0E, 0x0E, 0x0E, 0x1F, 0x00, 0x04, 0x00},   // bell
+    {0x04, 0x0E, 0x15, 0x04, 0x04, 0x04, 0x04, 0x00},   // arrow up
+    {0x04, 0x04, 0x04, 0x04, 0x15, 0x0E, 0x04, 0x00},   // arrow down
+    {0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00},   // big digit top
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F},   // big digit bottom
+    {0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F},   // big digit both
+};
+
+// Rows of the run-time glyphs
+__xdata uint8_t glyph_user[GLYPH_USER_COUNT][8];
+
+// Glyph id held by each slot, and the use stamp that orders them
+__xdata uint8_t glyph_slot_id[GLYPH_SLOTS];
+__xdata uint16_t glyph_slot_used[GLYPH_SLOTS];
+__xdata uint16_t glyph_clock = 0;
+
+// Acquires served from CGRAM, acquires that had to upload, and acquires
+// refused because every slot was on screen
+__xdata uint16_t glyph_hits = 0;
+__xdata uint16_t glyph_uploads = 0;
+__xdata uint16_t glyph_refused = 0;
+
+// Queue the rows of a glyph into a slot
+static void glyph_upload(uint8_t slot, uint8_t id)
+{
+    if (id < GLYPH_BUILTIN_COUNT) {
+        lcd_queue_custom_char(slot, (uint8_t *)glyph_builtin[id]);
+    } else {
+        lcd_queue_custom_char(slot, glyph_user[id - GLYPH_BUILTIN_COUNT]);
+    }
+    glyph_uploads++;
+}
+
+void glyph_init(void)
+{
+    for (uint8_t i = 0; i < GLYPH_SLOTS; i++) {
+        glyph_slot_id[i] = GLYPH_NO_SLOT;
+        glyph_slot_used[i] = 0;
+    }
+    glyph_clock = 0;
+}
+
+void glyph_define(uint8_t n, uint8_t *rows)
+{
+    uint8_t id = GLYPH_USER(n);
+
+    if (n >= GLYPH_USER_COUNT) {
+        return;
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        glyph_user[n][i] = rows[i];
+    }
+    for (uint8_t i = 0; i < GLYPH_SLOTS; i++) {
+        if (glyph_slot_id[i] == id) {
+            glyph_upload(i, id);    // shown cells pick up the new shape
+        }
+    }
+}
+
+uint8_t glyph_acquire(uint8_t id)
+{
+    uint8_t victim = GLYPH_NO_SLOT;
+    uint8_t shown;
+
+    if (id >= GLYPH_COUNT) {
+        return GLYPH_NO_SLOT;
+    }
+
+    glyph_clock++;
+    for (uint8_t i = 0; i < GLYPH_SLOTS; i++) {
+        if (glyph_slot_id[i] == id) {
+            glyph_slot_used[i] = glyph_clock;
+            glyph_hits++;
+            return i;
+        }
+    }
+
+    // Empty slots first, then the oldest stamp, never one still on screen
+    shown = lcd_shadow_glyphs();
+    for (uint8_t i = 0; i < GLYPH_SLOTS; i++) {
+        if (glyph_slot_id[i] != GLYPH_NO_SLOT && (shown & (1 << i))) {
+            continue;
+        }
+        if (victim == GLYPH_NO_SLOT ||
+            (glyph_slot_id[victim] != GLYPH_NO_SLOT &&
+             (glyph_slot_id[i] == GLYPH_NO_SLOT ||
+              (uint16_t)(glyph_clock - glyph_slot_used[i]) >
+              (uint16_t)(glyph_clock - glyph_slot_used[victim])))) {
+            victim = i;
+        }
+    }
+    if (victim == GLYPH_NO_SLOT) {
+        glyph_refused++;
+        return GLYPH_NO_SLOT;
+    }
+
+    glyph_slot_id[victim] = id;
+    glyph_slot_used[victim] = glyph_clock;
+    glyph_upload(victim, id);
+    return victim;
+}
+
+void glyph_put(uint8_t addr, uint8_t id)
+{
+    char cc[2];
+
+    cc[0] = glyph_acquire(id);
+    if ((uint8_t)cc[0] == GLYPH_NO_SLOT) {
+        return;
+    }
+    cc[1] = '\0';
+    // Code 0 would end the string, so write it as its CGRAM alias 8
+    if (cc[0] == 0) {
+        cc[0] = 8;
+    }
+    lcd_queue_putstr(addr, cc);
+}
+
+void glyph_forget_slot(uint8_t slot)
+{
+    if (slot < GLYPH_SLOTS) {
+        glyph_slot_id[slot] = GLYPH_NO_SLOT;
+    }
+}
+
+void glyph_print_stats(void)
+{
+    printf("\n\rGlyph cache hits : %u", glyph_hits);
+    printf("\n\rGlyph uploads    : %u", glyph_uploads);
+    printf("\n\rGlyph refused    : %u\n\r", glyph_refused);
+}
@@ -0,0 +1,91 @@
+// Author: Lokesh Senthil Kumar
+// glyph.h file declares the CGRAM glyph cache
+
+#ifndef _GLYPH_H_
+#define _GLYPH_H_
+
+#include <stdint.h>
+
+/*
+ * The HD44780 has 8 CGRAM slots (character codes 0 to 7). Glyphs are named by
+ * an id; glyph_acquire uploads a glyph into the least recently used slot only
+ * when it is not already resident. A slot whose code is on screen (per the
+ * shadow buffer) is never evicted, as that would change the cells showing
+ * it. When all eight are on screen the acquire is refused, so no screen may
+ * show more than eight different glyphs at once. Blanking the cells is all
+ * it takes to release a glyph.
+ */
+#define GLYPH_SLOTS         8
+#define GLYPH_NO_SLOT       0xFF
+
+/* Built-in glyphs, rows in glyph.c */
+#define GLYPH_CU_TL         0       // "CU" logo, four quarters
+#define GLYPH_CU_TR         1
+#define GLYPH_CU_BL         2
+#define GLYPH_CU_BR         3
+#define GLYPH_BAR_1         4       // Horizontal bar, 1 to 5 columns lit
+#define GLYPH_BAR_2         5
+#define GLYPH_BAR_3         6
+#define GLYPH_BAR_4         7
+#define GLYPH_BAR_5         8
+#define GLYPH_BELL          9
+#define GLYPH_ARROW_UP      10
+#define GLYPH_ARROW_DOWN    11
+#define GLYPH_BIG_TOP       12      // Big digit strokes: bar at the top,
+#define GLYPH_BIG_BOTTOM    13      // at the bottom,
+#define GLYPH_BIG_BOTH      14      // and both
+#define GLYPH_BUILTIN_COUNT 15
+
+/* Glyphs defined at run time follow the built-in ones */
+#define GLYPH_USER_COUNT    8
+#define GLYPH_USER(n)       (GLYPH_BUILTIN_COUNT + (n))
+#define GLYPH_COUNT         (GLYPH_BUILTIN_COUNT + GLYPH_USER_COUNT)
+
+/**
+ * @brief   Forgets every slot assignment, e.g. after CGRAM was overwritten.
+ * @return  void
+ */
+void glyph_init(void);
+
+/**
+ * @brief   Stores the rows of a run-time glyph.
+ * @details If the glyph is resident its slot is uploaded again.
+ * @param   n: The user glyph number, 0 to GLYPH_USER_COUNT - 1.
+ * @param   rows: The eight row patterns.
+ * @return  void
+ */
+void glyph_define(uint8_t n, uint8_t *rows);
+
+/**
+ * @brief   Makes a glyph resident and marks it most recently used.
+ * @details Uploads it through the LCD queue (one CGRAM address set and eight
+ *          data writes) only if it is not resident already.
+ * @param   id: The glyph id.
+ * @return  The character code (0 to 7) to write to DDRAM, or GLYPH_NO_SLOT
+ *          for an unknown id or when every slot is on screen.
+ */
+uint8_t glyph_acquire(uint8_t id);
+
+/**
+ * @brief   Acquires a glyph and queues it at a DDRAM address.
+ * @param   addr: The DDRAM address.
+ * @param   id: The glyph id.
+ * @return  void
+ */
+void glyph_put(uint8_t addr, uint8_t id);
+
+/**
+ * @brief   Drops the glyph held in a slot that was written directly.
+ * @param   slot: The character code, 0 to 7.
+ * @return  void
+ */
+void glyph_forget_slot(uint8_t slot);
+
+/**
+ * @brief   Prints the glyph cache hits, uploads and refusals to the UART
+ *          console.
+ * @return  void
+ */
+void glyph_print_stats(void);
+
+#endif // _GLYPH_H_
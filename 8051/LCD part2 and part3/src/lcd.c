@@ -9,142 +9,149 @@
 #include "at89c51ed2.h"
 
 #include "uart.h"
-
-// Pin definitions for the LCD
-#define RS P1_2
-#define RW P1_3
-
-// LCD memory addresses for each row
-#define LCD_ROW_0_ADDR 0x00
-#define LCD_ROW_1_ADDR 0x40
-#define LCD_ROW_2_ADDR 0x10
-#define LCD_ROW_3_ADDR 0x50
-
-// The number of cycles required to wait for one millisecond
-#define one_MS       82
-
-// The address used to read LCD commands
-#define LCD_COMMAND_READ_ADDRESS    (uint8_t *)0xF000
-
-// The LCD read pointer
-volatile uint8_t __at(LCD_COMMAND_READ_ADDRESS) lcd_ptr;
-
-// Global variables used to display time on the LCD
-extern volatile char tenth_of_second;
-extern volatile char seconds_ones_digit;
-extern volatile char seconds_tens_digit;
-extern volatile char minutes_ones_digit;
-extern volatile char minutes_tens_digit;
+#include "lcd.h"
+#include "clock.h"
+#include "timebase.h"
+#include "startup.h"
+#include "glyph.h"
+#include "lcd_hw.h"
+#ifdef LCD_BACKEND_I2C
+#include "i2c.h"
+#endif
+
+// Busy-flag reads that found the LCD busy, and waits that timed out
+__xdata uint32_t lcd_busy_polls = 0;
+__xdata uint16_t lcd_busy_timeouts = 0;
+
+// Reset to usable LCD: the C startup plus millis() when init_lcd finished.
+// Only irq_init and uart_init, a few us, run between the two.
+__xdata uint32_t lcd_ready_ms = 0;
+
+// Command/data queue, one byte written per tick by the DEFER_LCD handler. The
+// tick only compares head and tail, it never writes either.
+RING_DEFINE(lcd_q, lcd_q_entry_t, LCD_QUEUE_SIZE, __xdata);
+uint8_t lcd_q_peak = 0;     // most bytes ever waiting
+
+// Called from lcd_queue_service when the queue runs empty
+void (*lcd_queue_callback)(void) = 0;
+
+// Software copy of the DDRAM address counter. It follows every goto and
+// character write, including queued ones, so the panel is only read on a
+// resync. For queued output it is where the cursor will be once drained.
+volatile uint8_t lcd_cursor = 0;
+
+// DDRAM and CGRAM read back for the hexdump
+__xdata uint8_t lcd_dump_buf[LCD_DDRAM_LINE * 2 + LCD_CGRAM_SIZE];
 
 // The cursor address saved for later use
 uint8_t save_cursor_address = 0;
 
-// The string pointer
-char *string;
+// Line typed at the string and address prompts
+#define LCD_LINE_MAX    49
+__xdata char lcd_line[LCD_LINE_MAX + 1];
+__xdata uint8_t lcd_line_len;
 
-// Function to implement a delay for a specified number of milliseconds
-void delay(int millisec)
-{
-   
-    for(int i = 0; i < millisec * one_MS; i++){};
-}
+// Prompt state while the answers arrive a character per console run
+__xdata char lcd_x_ch;                  // row typed at the X prompt
+__xdata uint8_t lcd_xy_step;            // 0 waiting for X, 1 for Y
+__xdata char lcd_hex_digit;             // first digit at the hex prompt, 0 if none
+__xdata uint8_t lcd_hex_value;
+__xdata uint8_t lcd_custom_step;        // see custom_char_key
+__xdata uint8_t lcd_custom_row;
+__xdata unsigned char lcd_custom_code;
+__xdata unsigned int lcd_custom_addr;
+__xdata unsigned char lcd_custom_rows[8];
 
+// Shadow of the 64 visible DDRAM cells, row-major (row * 16 + column)
+__xdata char lcd_shadow[LCD_CELLS];
 
-// Wait for the LCD to become not busy
-void BUSY_WAIT(void)
-{
-    
-    const uint8_t BF_MASK = 0x80;
+// One bit per cell, set when the shadow differs from the panel
+__xdata uint8_t lcd_dirty[LCD_CELLS / 8];
 
-    // Address of the LCD command register
-    const uint16_t COMMAND_LOC = 0xF000;
+// Bumped on every shadow change so watchers can skip unchanged frames
+volatile uint8_t lcd_shadow_gen = 0;
 
-    // Set control pins for reading command
-    RS = 0;
-    RW = 1;
+// DDRAM address of the first cell of each row
+static __code uint8_t lcd_row_addr[LCD_ROWS] = {
+    LCD_ROW_0_ADDR, LCD_ROW_1_ADDR, LCD_ROW_2_ADDR, LCD_ROW_3_ADDR
+};
 
-    // Read status register until busy flag is cleared
-    while ((* (volatile uint8_t *) COMMAND_LOC) & BF_MASK){
-        
-        delay(10);
+// Wait for the LCD to become not busy
+uint8_t BUSY_WAIT(void)
+{
+    uint16_t polls = LCD_BUSY_TIMEOUT_POLLS;
+
+    // Read status register until busy flag is cleared, BF drops within
+    // ~40 us for most commands, so there is no delay between reads
+    while (lcd_hw_busy()){
+        if (--polls == 0) {
+            lcd_busy_timeouts++;        // panel missing or stuck
+            return LCD_ERR_TIMEOUT;
+        }
     }
+    lcd_busy_polls += LCD_BUSY_TIMEOUT_POLLS - polls;
+    return LCD_OK;
 }
 
-// Set initial values of global variables used to display time on the LCD
+// Have the clock redrawn in full on the freshly cleared panel
 void INIT_TIME(void)
 {
-  
-    tenth_of_second     = '0';
-    seconds_ones_digit  = '0';
-    seconds_tens_digit  = '0';
-    minutes_ones_digit  = '0';
-    minutes_tens_digit  = '0';
+    clock_invalidate();     // the panel was cleared, the time itself is kept
 }
 
 void init_lcd(void){
-    // Set RS and RW pins to 0
-    RS = 0;
-    RW = 0;
-    // Delay for 160 ms
-    delay(160);
-
-    // Send 0x30 to the LCD
-    lcd_ptr = 0x30;
-    delay(170);
-    lcd_ptr = 0x30;
-    delay(150);
-
-    lcd_ptr = 0x30;
-    BUSY_WAIT();
-    // Set RS and RW pins to 0
-    RS = 0;
-    RW = 0;
-    lcd_ptr = 0x38;
-    // Wait until the LCD is not busy
-    BUSY_WAIT();
+    // Power-on wait, counted from timebase start so the time spent in
+    // earlier init code is not waited again
+    while (!timebase_expired(LCD_POWER_ON_MS)) {
+    }
 
-    // Set RS and RW pins to 0
-    RS = 0;
-    RW = 0;
-    lcd_ptr = 0x0F;
-   
+    // Reset sequence and function set for the selected backend
+    lcd_hw_init();
+
+    lcd_hw_write(LCD_RS_INSTRUCTION, 0x0F);     // display, cursor and blink on
     BUSY_WAIT();
 
-    // Set RS and RW pins to 0
-    RS = 0;
-    RW = 0;
-    lcd_ptr = 0x01;
-    
+    lcd_hw_write(LCD_RS_INSTRUCTION, 0x01);     // clear display
     BUSY_WAIT();
 
-    // Set RS and RW pins to 0
-    RS = 0;
-    RW = 0;
-    // Send 0x06 to the LCD
-    lcd_ptr = 0x06;
-    
+    lcd_hw_write(LCD_RS_INSTRUCTION, 0x06);     // increment, no shift
     BUSY_WAIT();
 
+    // The panel is blank, start the shadow from the same state
+    lcd_shadow_reset();
+    lcd_cursor = 0x00;          // clear display homes the cursor
+
+    // Queued writes go out from here on
+    lcd_queue_init();
+
+    // CGRAM content is unknown after power up
+    glyph_init();
+
     // Call INIT_TIME function to initialize time variables
     INIT_TIME();
+
+    lcd_ready_ms = millis() + (startup_us + 500) / 1000;
 }
 
 // Function to get the cursor address
 uint8_t get_cursor_address(){
-    RS = 0; // Set RS pin low
-    RW = 1; // Set RW pin high
+    return lcd_cursor; // tracked in software, no bus read
+}
 
-    uint8_t address = lcd_ptr & (~0x80);
-    return address; // Return the address
+// Read the address counter from the panel and adopt it as the cursor
+uint8_t lcd_cursor_resync(void)
+{
+    lcd_sync();             // the counter is only stable with an empty queue
+    lcd_cursor = lcd_hw_read(LCD_RS_INSTRUCTION) & (~0x80);
+    return lcd_cursor;
 }
 
 // Function to move the cursor to the given address
 void lcdgotoaddr(unsigned char address){
-    RS = 0; // Set RS pin low
-    RW = 0; // Set RW pin low
+    lcd_cursor = address & 0x7F; // Track the new position
 
     address = address | 0x80; // Set the MSB of address to 1
-    lcd_ptr = address; // Assign the address to lcd_ptr
+    lcd_hw_write(LCD_RS_INSTRUCTION, address); // Set DDRAM address
     BUSY_WAIT(); // Wait for the LCD to be not busy
 }
 
@@ -184,27 +191,255 @@ void lcdgotoxy(unsigned char row, unsigned char column) {
 
 
 void lcdputch(char cc){
-    unsigned char address = get_cursor_address(); // get the current cursor address
-    RS=1;       
-    RW=0;       
-    lcd_ptr=cc;     // character to the LCD data bus
+    unsigned char address = lcd_cursor; // get the current cursor address
+    uint8_t next = lcd_next_addr(address);
+    uint8_t cell = lcd_addr_to_cell(address);
+    lcd_hw_write(LCD_RS_DATA, cc);     // character to the LCD
     BUSY_WAIT();  // wait LCD is not busy
 
-    // check cursor position and move cursor to next line if needed
-    switch(address) {
+    // the panel now holds cc, keep the shadow in step
+    if (cell != LCD_NO_CELL) {
+        lcd_shadow[cell] = cc;
+        lcd_dirty[cell >> 3] &= ~(1 << (cell & 0x07));
+        lcd_shadow_gen++;
+    }
+
+    // move cursor to next line if the write reached the end of a row
+    if (next != (uint8_t)(address + 1)) {
+        lcdgotoaddr(next);
+    } else {
+        lcd_cursor = next;      // auto-increment moved the panel cursor
+    }
+}
+
+// Map a DDRAM address to its shadow cell, LCD_NO_CELL if it is off screen
+uint8_t lcd_addr_to_cell(uint8_t addr)
+{
+    if (addr & 0xA0) {
+        return LCD_NO_CELL;         // columns 16-39 of each DDRAM line
+    }
+    // 0x00 row 0, 0x40 row 1, 0x10 row 2, 0x50 row 3
+    return ((addr & 0x40) ? 16 : 0) + ((addr & 0x10) ? 32 : 0) + (addr & 0x0F);
+}
+
+// DDRAM address of a shadow cell
+uint8_t lcd_cell_to_addr(uint8_t cell)
+{
+    return lcd_row_addr[cell >> 4] | (cell & 0x0F);
+}
+
+// Fill the shadow with blanks and mark it in sync with a cleared panel
+void lcd_shadow_reset(void)
+{
+    memset(lcd_shadow, ' ', LCD_CELLS);
+    memset(lcd_dirty, 0, sizeof(lcd_dirty));
+    lcd_shadow_gen++;
+}
+
+void lcd_fb_putch(uint8_t addr, char cc)
+{
+    uint8_t cell = lcd_addr_to_cell(addr);
+
+    // Only a real change needs to reach the panel
+    if (cell != LCD_NO_CELL && lcd_shadow[cell] != cc) {
+        lcd_shadow[cell] = cc;
+        lcd_dirty[cell >> 3] |= 1 << (cell & 0x07);
+        lcd_shadow_gen++;
+    }
+}
+
+void lcd_fb_putstr(uint8_t addr, char *ss)
+{
+    uint8_t cell = lcd_addr_to_cell(addr);
+
+    if (cell == LCD_NO_CELL) {
+        return;
+    }
+    while (*ss != '\0') {
+        lcd_fb_putch(lcd_cell_to_addr(cell), *ss++);
+        cell = (cell + 1) & (LCD_CELLS - 1);    // row 3 wraps to row 0
+    }
+}
+
+uint8_t lcd_shadow_glyphs(void)
+{
+    uint8_t used = 0;
+    uint8_t cc;
+
+    for (uint8_t cell = 0; cell < LCD_CELLS; cell++) {
+        cc = lcd_shadow[cell];
+        if (cc < 16) {
+            used |= 1 << (cc & 0x07);
+        }
+    }
+    return used;
+}
+
+uint8_t lcd_flush(void)
+{
+    uint8_t written = 0;
+    uint8_t next_addr = 0xFF;       // where auto-increment leaves the cursor
+    uint8_t save_cursor;
+    uint8_t addr, cell, mask;
+
+    save_cursor = get_cursor_address();
+
+    // Walk the cells in DDRAM address order (rows 0, 2, 1, 3) so a run that
+    // crosses from 0x0F to 0x10 or 0x4F to 0x50 needs no new address
+    for (uint8_t i = 0; i < LCD_CELLS; i++) {
+        addr = (i & 0x1F) | ((i & 0x20) << 1);
+        cell = lcd_addr_to_cell(addr);
+        mask = 1 << (cell & 0x07);
+
+        if ((cell & 0x07) == 0 && lcd_dirty[cell >> 3] == 0) {
+            i += 7;                 // skip eight clean cells at once
+            continue;
+        }
+        if (!(lcd_dirty[cell >> 3] & mask)) {
+            continue;
+        }
+
+        if (addr != next_addr) {
+            lcd_queue_cmd(0x80 | addr);     // set DDRAM address only after a gap
+        }
+        lcd_queue_data(lcd_shadow[cell]);
+
+        lcd_dirty[cell >> 3] &= ~mask;
+        next_addr = addr + 1;
+        written++;
+    }
+
+    if (written) {
+        lcd_queue_goto(save_cursor);        // put the user's cursor back
+    }
+    return written;
+}
+
+// Address that follows addr, with the same row wrap as lcdputch
+uint8_t lcd_next_addr(uint8_t addr)
+{
+    switch (addr) {
         case 0x0F:
-            lcdgotoxy('1', '0');
-            break;
-        case 0x1F:
-            lcdgotoxy('0', '0');
-            break;
+            return LCD_ROW_1_ADDR;
         case 0x4F:
-            lcdgotoxy('2', '0');
-            break;
+            return LCD_ROW_2_ADDR;
+        case 0x1F:
         case 0x5F:
-            lcdgotoxy('0', '0');
-            break;
+            return LCD_ROW_0_ADDR;
+        default:
+            return addr + 1;
+    }
+}
+
+// Empty the queue; the DEFER_LCD handler drains it from then on
+void lcd_queue_init(void)
+{
+    RING_RESET(lcd_q);
+}
+
+// Write the oldest queued byte if the LCD is ready
+void lcd_queue_service(void)
+{
+    if (RING_EMPTY(lcd_q)) {
+        return;
+    }
+
+    if (lcd_hw_busy()) {
+        return;                 // still busy, try on the next tick
+    }
+
+    lcd_hw_write(RING_PEEK(lcd_q).rs, RING_PEEK(lcd_q).value);
+    RING_DROP(lcd_q);
+
+    if (RING_EMPTY(lcd_q) && lcd_queue_callback) {
+        lcd_queue_callback();
+    }
+}
+
+// Append one byte, waiting for room if the queue is full
+static void lcd_queue_put(uint8_t rs, uint8_t value)
+{
+    while (RING_FULL(lcd_q)) {
+        lcd_queue_service();        // the handler cannot run while we wait
+    }
+    RING_NEW(lcd_q).rs = rs;
+    RING_NEW(lcd_q).value = value;
+    RING_COMMIT(lcd_q);
+    RING_HIGH_WATER(lcd_q, lcd_q_peak);
+}
+
+void lcd_queue_cmd(uint8_t cmd)
+{
+    lcd_queue_put(0, cmd);
+}
+
+void lcd_queue_data(uint8_t value)
+{
+    lcd_queue_put(1, value);
+}
+
+void lcd_queue_goto(uint8_t addr)
+{
+    lcd_cursor = addr & 0x7F;
+    lcd_queue_cmd(0x80 | addr);
+}
+
+void lcd_queue_putstr(uint8_t addr, char *ss)
+{
+    uint8_t cell;
+
+    lcd_queue_goto(addr);
+    while (*ss != '\0') {
+        lcd_queue_data(*ss);
+
+        // The panel will show this character, keep the shadow in step
+        cell = lcd_addr_to_cell(addr);
+        if (cell != LCD_NO_CELL) {
+            lcd_shadow[cell] = *ss;
+            lcd_dirty[cell >> 3] &= ~(1 << (cell & 0x07));
+            lcd_shadow_gen++;
+        }
+
+        ss++;
+        if (lcd_next_addr(addr) != addr + 1) {
+            lcd_queue_goto(lcd_next_addr(addr));   // row wrap
+        }
+        addr = lcd_next_addr(addr);
+    }
+    lcd_cursor = addr;
+}
+
+void lcd_queue_custom_char(uint8_t code, uint8_t *rows)
+{
+    // One CGRAM address, then eight rows through auto-increment
+    lcd_queue_cmd(0x40 | (code << 3));
+    for (uint8_t i = 0; i < 8; i++) {
+        lcd_queue_data(rows[i]);
+    }
+    lcd_queue_goto(lcd_cursor);     // back to DDRAM at the tracked cursor
+}
+
+uint8_t lcd_queue_fill(void)
+{
+    return RING_COUNT(lcd_q);
+}
+
+uint8_t lcd_queue_idle(void)
+{
+    return RING_EMPTY(lcd_q);
+}
+
+void lcd_queue_on_done(void (*callback)(void))
+{
+    lcd_queue_callback = callback;
+}
+
+void lcd_sync(void)
+{
+    while (!RING_EMPTY(lcd_q)) {
+        lcd_queue_service();        // the handler cannot run while we wait
     }
+    BUSY_WAIT();                    // let the last queued byte finish
 }
 
 void lcdputstr(char *ss){
@@ -215,88 +450,103 @@ void lcdputstr(char *ss){
     }
 }
 void handler_lcdclear(void){
-    RS=0;               // set RS pin to low
-    RW=0;               // set RW pin to low
-    lcd_ptr=0x01;          
+    lcd_sync();         // let queued writes finish first
+    lcd_hw_write(LCD_RS_INSTRUCTION, 0x01);    // clear display
     BUSY_WAIT();          // wait until LCD is ready
+    lcd_shadow_reset();     // the panel is blank again
+    clock_invalidate();     // redraw every clock character
     lcdgotoaddr(0x00);      // move cursor to the beginning
     lcdputstr("       ");   // write 7 spaces to clear the first line
     lcdgotoaddr(0x00);      // move cursor back to the beginning
     printf("\n\rLCD Cleared!!\r\n"); // LCD has been cleared
 }
 
+static uint8_t wr_c_key(char c)
+{
+    char glyph[2];
+
+    glyph[0] = c;
+    glyph[1] = '\0';
+    lcd_queue_putstr(get_cursor_address(), glyph); // queue the character for the LCD
+    printf("\n\rEntered Char = %c\n\r\n\r",c); // print the entered character
+    return UART_READ_DONE;
+}
+
 void handler_wr_c_lcd(void)
 {
-    char LCD_int;
     printf("\n\rEnter Character for LCD !!\r\n"); // print a message to ask the user to enter a character
-    LCD_int = getchar();  // get the input character from the user
-    __critical
-    {
-        lcdputch(LCD_int); // write the input character to the LCD
+    uart_read_with(wr_c_key);
+}
+
+static uint8_t wr_str_key(char ch)
+{
+    if(ch=='\r'){                   // the string ends at the enter key
+        lcd_line[lcd_line_len]='\0';
+        lcd_queue_putstr(get_cursor_address(), lcd_line);  // queue the string for the LCD
+        printf("Entered String = %s\n\r\n\r",lcd_line); // print the entered string
+        return UART_READ_DONE;
     }
-    printf("\n\rEntered Char = %c\n\r\n\r",LCD_int); // print the entered character
-    
+    if (lcd_line_len < LCD_LINE_MAX) {
+        lcd_line[lcd_line_len++]=ch;    // store each character, the rest is dropped
+    }
+    return UART_READ_MORE;
 }
 
 void handler_wr_str_lcd(void)
 {
     printf(" \n\rEnter String for LCD !!\r\n"); // print a message to ask the user to enter a string
-    int k = 1;
-    int i = 0;
-    char ch = 0;
-
-    while(k){
-        ch=getchar();       //  until the enter key is pressed
-        if(ch=='\r'){
-            k=0;            // exit the loop when the enter key is pressed
-        }
-        else{
-            *(string+i)=ch; // store each characte
-            i++;
-        }
-    }
-    *(string+i)='\0';       // add null character
-    __critical
-    {
-        lcdputstr(string);  // write the string to the LCD
-    }
-    printf("Entered String = %s\n\r\n\r",string); // print the entered string
-    
+    lcd_line_len = 0;
+    uart_read_with(wr_str_key);
 }
 
-// This function is used to handle the user input to move the cursor on the LCD to the specified coordinates
-void handler_lcdgotoxy(void)
+// Asks for the X co-ordinate; gotoxy_key takes the answers
+static void gotoxy_prompt(void)
 {
-    // user to input the x-coordinate
-    char x_coordinate_ch;
     printf(" \n\rEnter X-Co-ordinate for LCD !!\r\n");
-    x_coordinate_ch  = toupper(getchar());
+    lcd_xy_step = 0;
+}
 
-    // print the user input for x-coordinate
-    printf("X-Cordinate = %c\n\r",x_coordinate_ch);
+static uint8_t gotoxy_key(char c)
+{
+    char y_coordinate_ch;
 
-    // user to input the y-coordinate
-    printf(" \n\rEnter Y-Co-ordinate for LCD !!\r\n");
-    char y_coordinate_ch  = toupper(getchar());
+    if (lcd_xy_step == 0) {
+        // print the user input for x-coordinate
+        lcd_x_ch = toupper(c);
+        printf("X-Cordinate = %c\n\r",lcd_x_ch);
+
+        // user to input the y-coordinate
+        printf(" \n\rEnter Y-Co-ordinate for LCD !!\r\n");
+        lcd_xy_step = 1;
+        return UART_READ_MORE;
+    }
 
     // user input for y-coordinate
+    y_coordinate_ch = toupper(c);
     printf("Y-Cordinate = %c\n\r",y_coordinate_ch);
 
     // if the user input is not a valid coordinate
-    if (x_coordinate_ch >= '0' && x_coordinate_ch <= '3'){
+    if (lcd_x_ch >= '0' && lcd_x_ch <= '3'){
     } else if (y_coordinate_ch >= '0' && y_coordinate_ch <= 'F') {
     } else {
         printf("Invalid coordinate!!\n\r");
-        return;
+        return UART_READ_DONE;
     }
 
     // move the cursor to the specified coordinates on the LCD
-    __critical {
-        lcdgotoxy(x_coordinate_ch, y_coordinate_ch);
-    }
+    lcd_sync();         // queued writes first, the direct ones follow them
+    lcdgotoxy(lcd_x_ch, y_coordinate_ch);
 
     // print the message indicating the cursor movement completed
     printf(" \n\rCursor Movement Completed!!\r\n");
+    return UART_READ_DONE;
+}
+
+// This function is used to handle the user input to move the cursor on the LCD to the specified coordinates
+void handler_lcdgotoxy(void)
+{
+    gotoxy_prompt();
+    uart_read_with(gotoxy_key);
 }
 
 long int hex_to_int(char *hex_str) {
@@ -336,27 +586,24 @@ long int hex_to_int(char *hex_str) {
     return result;  // Return the final converted value
 }
 
-// This function handles the command to go to a specific address on the LCD
-void handler_lcdgotoaddress(void)
+static uint8_t gotoaddress_key(char c)
 {
-    char str[50];
-    printf(" \n\rEnter address for LCD !!\r\n");
-
-    // Read in the address string from the user
-    int i = 0;
-    char c = getchar();
-    putchar(c);
-    while (c != '\r' && i < 49) { // Read characters until enter is pressed or limit is reached
-        str[i++] = c;
-        c = getchar();
+    if (lcd_line_len == 0) {
+        putchar(c);
+    }
+    if (c != '\r' && lcd_line_len < LCD_LINE_MAX) {   // Read characters until enter is pressed or limit is reached
+        lcd_line[lcd_line_len++] = c;
+        if (lcd_line_len < LCD_LINE_MAX) {
+            return UART_READ_MORE;
+        }
     }
-    str[i] = '\0';
+    lcd_line[lcd_line_len] = '\0';
 
    
-    printf("Address Entered as %s\n\r",str);
+    printf("Address Entered as %s\n\r",lcd_line);
 
     // Convert the address string to a long integer using base 16
-    long int num = hex_to_int(str);
+    long int num = hex_to_int(lcd_line);
 
     if (!((num >= 0x00 && num <= 0x0F) ||   
           (num >= 0x40 && num <= 0x4F) ||   
@@ -364,14 +611,20 @@ void handler_lcdgotoaddress(void)
           (num >= 0x50 && num <= 0x5F))) 
     {  
         printf("\n\rInvalid address for a LCD.\n\r");
-        return;
+        return UART_READ_DONE;
     }
     // Go to the specified address on the LCD
-    __critical
-    {
-        lcdgotoaddr((char)num);
-    }
-    return;
+    lcd_sync();         // queued writes first, the direct ones follow them
+    lcdgotoaddr((char)num);
+    return UART_READ_DONE;
+}
+
+// This function handles the command to go to a specific address on the LCD
+void handler_lcdgotoaddress(void)
+{
+    printf(" \n\rEnter address for LCD !!\r\n");
+    lcd_line_len = 0;
+    uart_read_with(gotoaddress_key);
 }
 
 // This function handles the command to stop the clock
@@ -379,8 +632,7 @@ void handler_stop_time(void)
 {
     printf(" \n\rTime Paused !!\r\n");
 
-    // Set the timer control register bit 4 to 0 to stop the timer
-    TCON &=~(0x10);
+    clock_pause();      // Stop Timer 0 and blink the colon
 }
 
 // This function handles the command to resume the clock
@@ -388,7 +640,7 @@ void handler_resume_time(void)
 {
     //resume clock
     printf(" \n\rTime Resumed !!\r\n");
-    TCON |=0x10;
+    clock_resume();
 }
 
 // Function to reset the timer
@@ -396,11 +648,7 @@ void handler_reset_time(void)
 {
     printf(" \n\rTime Reset !!\r\n");
 
-    tenth_of_second     = '0';
-    seconds_ones_digit  = '0';
-    seconds_tens_digit  = '0';
-    minutes_ones_digit  = '0';
-    minutes_tens_digit  = '0';
+    clock_reset();
 }
 
 // Function to read from a specific address in the LCD
@@ -409,74 +657,121 @@ uint8_t read_lcd_address(uint8_t is_ddram, uint8_t address) {
     if (is_ddram == 1) {
         lcdgotoaddr(address);
     } else {
-        RS = 0;
-        RW = 0;
-        lcd_ptr = address;
+        lcd_hw_write(LCD_RS_INSTRUCTION, address);
         BUSY_WAIT();
     }
 
-    // Set LCD to read mode
-    RS = 1;
-    RW = 1;
-
     // Return the value stored at the specified address
-    return lcd_ptr;
+    return lcd_hw_read(LCD_RS_DATA);
 }
-void handler_lcd_hexdump(void)
+// Read n bytes in one auto-increment pass after a single set-address command
+void lcd_read_block(uint8_t set_addr, __xdata uint8_t *buf, uint8_t n)
 {
-    __critical{
-        save_cursor_address=get_cursor_address();       // Save the current cursor address
-        printf("\n\rPrinting Hexdump of DDRAM\n\r");
+    lcd_hw_write(LCD_RS_INSTRUCTION, set_addr);
+    BUSY_WAIT();
 
-        // Loop through DDRAM addresses and print hex values
-        for(uint16_t k=0x00;k<=0x5F;k++){
-            if(k%16 == 0){                              // Print new line and address every 16 bytes
-                printf("\n\r0x%02x: ",k);
-            }
-            printf("0x%02x ",read_lcd_address(1,k));    // Read and print the value at the current address
-        }
+    while (n--) {
+        *buf++ = lcd_hw_read(LCD_RS_DATA);     // reading moves the address counter on
+        BUSY_WAIT();
+    }
+}
 
-        printf("\n\r\n\rPrinting Hexdump of CGRAM\n\r");
+// Print "0xAA: " and then "0xDD " for each byte, without printf
+static void hexdump_line(uint8_t addr, __xdata uint8_t *buf, uint8_t n)
+{
+    static __code char hex_digit[16] = "0123456789abcdef";
+    __xdata char line[8 + 5 * 16];
+    uint8_t pos = 0;
+
+    line[pos++] = '\n';
+    line[pos++] = '\r';
+    line[pos++] = '0';
+    line[pos++] = 'x';
+    line[pos++] = hex_digit[addr >> 4];
+    line[pos++] = hex_digit[addr & 0x0F];
+    line[pos++] = ':';
+    line[pos++] = ' ';
+    while (n--) {
+        line[pos++] = '0';
+        line[pos++] = 'x';
+        line[pos++] = hex_digit[*buf >> 4];
+        line[pos++] = hex_digit[*buf & 0x0F];
+        line[pos++] = ' ';
+        buf++;
+    }
+    for (uint8_t i = 0; i < pos; i++) {
+        putchar(line[i]);
+    }
+}
 
-        // Loop through CGRAM addresses and print hex values
-        for(uint16_t k=0x40;k<=0x7F;k++){
-            if(k%16 == 0){                              // Print new line and address every 16 bytes
-                printf("\n\r0x%02x: ",k);
-            }
-            printf("0x%02x ",read_lcd_address(0,k));    // Read and print the value at the current address
-        }
+// Print a block 16 bytes per line; ends of DDRAM lines give short rows
+static void hexdump_block(uint8_t addr, __xdata uint8_t *buf, uint8_t n)
+{
+    uint8_t count;
+
+    while (n) {
+        count = (n < 16) ? n : 16;
+        hexdump_line(addr, buf, count);
+        addr += count;
+        buf += count;
+        n -= count;
+    }
+}
 
-        printf("\n\r");
-        lcdgotoaddr(save_cursor_address);               // Restore the original cursor position
+void handler_lcd_hexdump(void)
+{
+    lcd_sync();     // queued writes first, then read the panel back
 
-    }
+    // Each DDRAM line holds 40 bytes: 0x00-0x27 and 0x40-0x67. The address
+    // counter runs from 0x27 to 0x40, so one pass reads both lines.
+    lcd_read_block(0x80 | 0x00, lcd_dump_buf, LCD_DDRAM_LINE * 2);
+    lcd_read_block(0x40, lcd_dump_buf + LCD_DDRAM_LINE * 2, LCD_CGRAM_SIZE);
+    lcdgotoaddr(lcd_cursor);                        // Restore the original cursor position
+
+    printf("\n\rPrinting Hexdump of DDRAM\n\r");
+    hexdump_block(0x00, lcd_dump_buf, LCD_DDRAM_LINE);
+    hexdump_block(0x40, lcd_dump_buf + LCD_DDRAM_LINE, LCD_DDRAM_LINE);
+
+    printf("\n\r\n\rPrinting Hexdump of CGRAM\n\r");
+    hexdump_block(0x40, lcd_dump_buf + LCD_DDRAM_LINE * 2, LCD_CGRAM_SIZE);
+    printf("\n\r");
 }
 
-unsigned char get_hex_value(void) {
-    unsigned char digit1, digit2, hex_value;
+// Asks for a hex value; hex_key takes the two digits
+static void hex_prompt(void)
+{
     printf("\n\rEnter a hexadecimal value between (00 to 1F) or (40 to 58): ");
+    lcd_hex_digit = 0;
+}
 
-    while (1) {                         //loop until a valid input is entered
-        digit1 = putchar(getchar());    //get first digit from input and display it
-        digit2 = putchar(getchar());    //get second digit from input and display it
+// Returns UART_READ_DONE with lcd_hex_value set once two valid digits arrive
+static uint8_t hex_key(char c)
+{
+    unsigned char digit1 = lcd_hex_digit;
+    unsigned char digit2 = c;
 
-        //check if both digits are valid hexadecimal digits (0-9 or A-F)
-        if (digit1 >= '0' && digit1 <= '9' && digit2 >= '0' && digit2 <= '9') {
-            hex_value = ((digit1 - '0') << 4) | (digit2 - '0'); //convert the digits to a hexadecimal value
-            break; //break the loop
-        }
-        //check if the first digit is valid and the second digit is a valid hexadecimal digit (A-F)
-        else if ((digit1 == '0' || digit1 == '1' || digit1 == '4' || digit1 == '5') && (digit2 >= 'A' && digit2 <= 'F')) {
-            hex_value = ((digit1 - '0') << 4) | (digit2 - '7'); //convert the digits to a hexadecimal value
-            break; //break the loop
-        }
-        else {
-            printf("\n\rInvalid input. ");      //display error message if input is invalid
-        }
-        printf("Please enter a valid input: "); //prompt user to enter a valid input
+    putchar(c);                         //display the digit
+    if (!digit1) {
+        lcd_hex_digit = c;              //first digit, wait for the second
+        return UART_READ_MORE;
+    }
+    lcd_hex_digit = 0;
+
+    //check if both digits are valid hexadecimal digits (0-9 or A-F)
+    if (digit1 >= '0' && digit1 <= '9' && digit2 >= '0' && digit2 <= '9') {
+        lcd_hex_value = ((digit1 - '0') << 4) | (digit2 - '0'); //convert the digits to a hexadecimal value
+        return UART_READ_DONE;
+    }
+    //check if the first digit is valid and the second digit is a valid hexadecimal digit (A-F)
+    else if ((digit1 == '0' || digit1 == '1' || digit1 == '4' || digit1 == '5') && (digit2 >= 'A' && digit2 <= 'F')) {
+        lcd_hex_value = ((digit1 - '0') << 4) | (digit2 - '7'); //convert the digits to a hexadecimal value
+        return UART_READ_DONE;
     }
-    return hex_value;                           //return the hexadecimal value
+    printf("\n\rInvalid input. ");          //display error message if input is invalid
+    printf("Please enter a valid input: "); //prompt user to enter a valid input
+    return UART_READ_MORE;
 }
+
 void create_custom_char(unsigned char code, unsigned char rows[]) {
     // Define some variables
     unsigned char six_bit = 0x40;
@@ -488,109 +783,99 @@ void create_custom_char(unsigned char code, unsigned char rows[]) {
     // Print a message indicating which character has been created
     printf("\n\rThe custom character  0x%x been created.", char_val);
 
-   
+    // Set the CGRAM address once, the LCD auto-increments through the rows
+    lcd_hw_write(LCD_RS_INSTRUCTION, char_val);
+    BUSY_WAIT();
+
     while (i < 8) {
-        // Set the RS and RW pins low
-        RS = 0;
-        RW = 0;
-        // Set the LCD pointer to the appropriate memory location
-        lcd_ptr = char_val + i;
-        
-        printf("\n\rLCD_ptr = %x", char_val + i);
-        // Wait for the LCD to become available
-        BUSY_WAIT();
-       
-        RS = 1;
-        RW = 0;
-        lcd_ptr = rows[i];
+        lcd_hw_write(LCD_RS_DATA, rows[i]);
         BUSY_WAIT();
         // Increment the row counter
         i++;
     }
-}
-
-void handler_custom_char(void) {
-
-    uint8_t j;
-    // Get current cursor address and save it in a variable
-    unsigned int addr = get_cursor_address();
 
-    printf("Enter the code for the custom character: ");
-    // Get the code for the custom character from the user
-    unsigned char code = getchar();
+    // The glyph cache no longer knows what this slot holds
+    glyph_forget_slot(code_val);
+}
 
-    // Print the code of the custom character entered by the user
-    printf("%c\n\r", code);
+// Asks for the value of the next custom character row
+static void custom_row_prompt(void)
+{
+    printf("\n\rEnter the value for the row %d: ", lcd_custom_row);
+    hex_prompt();
+}
 
-    // Initialize an array to store the values for the custom character rows
-    unsigned char rows[8];
+// Steps: 0 the code, 1 the eight rows, 2 the co-ordinates to show it at
+static uint8_t custom_char_key(char c)
+{
+    switch (lcd_custom_step) {
+    case 0:
+        lcd_custom_code = c;
+        // Print the code of the custom character entered by the user
+        printf("%c\n\r", c);
+        lcd_custom_row = 0;
+        custom_row_prompt();
+        lcd_custom_step = 1;
+        return UART_READ_MORE;
+
+    case 1:
+        if (hex_key(c) != UART_READ_DONE) {
+            return UART_READ_MORE;
+        }
+        lcd_custom_rows[lcd_custom_row++] = lcd_hex_value;
+        if (lcd_custom_row < 8) {
+            custom_row_prompt();
+            return UART_READ_MORE;
+        }
 
-    
-    while (j < 8) { // Loop through each row of the custom character and get its value from the user
-        printf("\n\rEnter the value for the row %d: ", j);
-        rows[j] = get_hex_value();
-        j++;
-    }
+        // The rest of this runs at once, so nothing else queues LCD writes
+        // between the sync and the direct writes
+        lcd_sync();
 
-    __critical { // Enter a critical section to prevent interruption
         // Call the function to create the custom character on the LCD
-        create_custom_char(code, rows);
+        create_custom_char(lcd_custom_code, lcd_custom_rows);
 
-        // Call the handler function for the LCD gotoxy command
-        handler_lcdgotoxy();
+        // Ask where to show it
+        gotoxy_prompt();
+        lcd_custom_step = 2;
+        return UART_READ_MORE;
+
+    default:
+        if (gotoxy_key(c) != UART_READ_DONE) {
+            return UART_READ_MORE;
+        }
 
         // Display the custom character on the LCD screen
-        lcdputch(code - '0');
+        lcd_sync();
+        lcdputch(lcd_custom_code - '0');
 
         // Move the cursor to the original position before the custom character was created
-        lcdgotoaddr(addr);
+        lcdgotoaddr(lcd_custom_addr);
+        return UART_READ_DONE;
     }
+}
+
+void handler_custom_char(void) {
 
+    // Get current cursor address and save it in a variable
+    lcd_custom_addr = get_cursor_address();
+
+    printf("Enter the code for the custom character: ");
+    lcd_custom_step = 0;
+    uart_read_with(custom_char_key);
 }
 
 void handle_cu_custom_char(void)
 {
     save_cursor_address = get_cursor_address();     // Get current cursor address and save it in a variable
 
-    // Create custom character 1
-    unsigned char ccode1 = '1';
-    unsigned char row_vals1[8] = {0x00, 0x00, 0x0F, 0x08, 0x08, 0x09, 0x09, 0x09};
-    __critical {
-        create_custom_char(ccode1, row_vals1);      // Call function to create custom character on the LCD
-        lcdgotoxy('1', '4');                        // Move cursor to position to display custom character 1
-        lcdputch(ccode1 - '0');                     // Display custom character 1 on the LCD screen
-    }
-
-    // Create custom character 2
-    unsigned char ccode2 = '2';
-    unsigned char row_vals2[8] = {0x00, 0x00, 0x18, 0x00, 0x00, 0x02, 0x02, 0x02};
-    __critical {
-        create_custom_char(ccode2, row_vals2);      // Call function to create custom character on the LCD
-        lcdgotoxy('1', '5');                        // Move cursor to position to display custom character 2
-        lcdputch(ccode2 - '0');                     // Display custom character 2 on the LCD screen
-        lcdgotoaddr(save_cursor_address);           // Move the cursor back to the original position
-    }
-
-    // Create custom character 3
-    unsigned char ccode3 = '3';
-    unsigned char row_vals3[8] = {0x09, 0x09, 0x09, 0x0F, 0x01, 0x01, 0x00, 0x00};
-    __critical {
-        create_custom_char(ccode3, row_vals3);      // Call function to create custom character on the LCD
-        lcdgotoxy('2', '4');                        // Move cursor to position to display custom character 3
-        lcdputch(ccode3 - '0');                     // Display custom character 3 on the LCD screen
-        lcdgotoaddr(save_cursor_address);           // Move the cursor back to the original position
-    }
-
-    // Create custom character 4
-    unsigned char ccode4 = '4';
-    unsigned char row_vals4[8] = {0x02, 0x02, 0x02, 0x1A, 0x02, 0x1E, 0x00, 0x00};
-    __critical {
-        create_custom_char(ccode4, row_vals4);      // Call function to create custom character on the LCD
-        lcdgotoxy('2', '5');                        // Move cursor to position to display custom character 4
-        lcdputch(ccode4 - '0');                     // Display custom character 4 on the LCD screen
-        lcdgotoaddr(save_cursor_address);           // Move the cursor back to the original position
-    }
+    // The glyph cache uploads each quarter only if it is not in CGRAM already
+    glyph_put(0x44, GLYPH_CU_TL);                   // Row 1, column 4
+    glyph_put(0x45, GLYPH_CU_TR);                   // Row 1, column 5
+    glyph_put(0x14, GLYPH_CU_BL);                   // Row 2, column 4
+    glyph_put(0x15, GLYPH_CU_BR);                   // Row 2, column 5
 
+    lcd_queue_goto(save_cursor_address);            // Move the cursor back to the original position
 }
 
 
@@ -601,18 +886,24 @@ void print_board_name(void)
     char * str;
     str = "8051 DEV BOARD";
 
-    // critical section to prevent interruption while writing to LCD
-    __critical
-    {
-        // move cursor to beginning of first line on LCD and print the string
-        lcdgotoaddr(0x00);
-        lcdputstr(str);
+    // queued, so interrupts stay enabled while the name is written
+    lcd_queue_putstr(0x00, str);
 
-        // move cursor to beginning of first line on LCD (in case string is longer than display width)
-        lcdgotoaddr(0x00);
-    }
+    // move cursor to beginning of first line on LCD (in case string is longer than display width)
+    lcd_queue_goto(0x00);
     return;
 }
 
-
-
+// Print how much time the driver spent waiting on the busy flag
+void handler_lcd_stats(void)
+{
+    printf("\n\rLCD busy polls   : %lu", lcd_busy_polls);
+    printf("\n\rLCD busy time    : ~%lu us", lcd_busy_polls * LCD_POLL_US);
+    printf("\n\rLCD busy timeouts: %u", lcd_busy_timeouts);
+    printf("\n\rLCD ready after  : %lu ms from reset", lcd_ready_ms);
+    printf("\n\rLCD queue peak   : %u/%u", (uint16_t)lcd_q_peak, LCD_QUEUE_SIZE - 1);
+    glyph_print_stats();
+#ifdef LCD_BACKEND_I2C
+    i2c_print_stats();
+#endif
+}
@@ -2,20 +2,73 @@
 #ifndef _LCD_H_
 #define _LCD_H_
 
-/**
- * @brief   Delays execution for the specified number of milliseconds.
- * @param   milliseconds: The number of milliseconds to delay execution.
- * @return  void
- */
-void delay(int milliseconds);
+#include <stdint.h>
+#include "ring.h"
+#include "defer.h"
+
+// LCD memory addresses for each row
+#define LCD_ROW_0_ADDR 0x00
+#define LCD_ROW_1_ADDR 0x40
+#define LCD_ROW_2_ADDR 0x10
+#define LCD_ROW_3_ADDR 0x50
+
+// Geometry of the 16x4 panel
+#define LCD_ROWS       4
+#define LCD_COLUMNS    16
+#define LCD_CELLS      64
+#define LCD_NO_CELL    0xFF
+
+// Controller memory: two DDRAM lines of 40 bytes, 64 bytes of CGRAM
+#define LCD_DDRAM_LINE 40
+#define LCD_CGRAM_SIZE 64
+
+// Busy-flag polling. One pass of the BUSY_WAIT loop (call to lcd_hw_busy,
+// MOVX read, bit test, 16-bit decrement and branch) is about 25 machine
+// cycles, ~27 us at 11.0592 MHz, so 200 polls allow ~5.4 ms against the
+// 1.52 ms worst case (clear display) of the HD44780.
+#define LCD_POLL_US            27
+#define LCD_BUSY_TIMEOUT_POLLS 200
+
+// HD44780 init timing (datasheet minimums at VCC = 4.5 V): 15 ms after power
+// on, more than 4.1 ms after the first function set and more than 100 us
+// after the second. Small margins are added.
+#define LCD_POWER_ON_MS    16
+#define LCD_INIT_WAIT1_US  4500
+#define LCD_INIT_WAIT2_US  150
+
+// Write queue drained one byte per 1 ms tick. The size must be a power of two.
+#define LCD_QUEUE_SIZE    64
+
+// One queued write: the RS level and the byte
+typedef struct {
+    uint8_t rs;
+    uint8_t value;
+} lcd_q_entry_t;
+
+// The queue, visible so the tick can see whether writes are waiting
+RING_EXTERN(lcd_q, lcd_q_entry_t, LCD_QUEUE_SIZE, __xdata);
+#define LCD_QUEUE_PENDING()     (!RING_EMPTY(lcd_q))
+
+// Run by the timebase ISR: at most one LCD byte per tick, written by the main loop
+#define LCD_TICK() do {                                 \
+        if (LCD_QUEUE_PENDING()) {                      \
+            DEFER_RAISE(DEFER_LCD);                     \
+        }                                               \
+    } while (0)
+
+// BUSY_WAIT status
+#define LCD_OK          0
+#define LCD_ERR_TIMEOUT 1
 
 /**
  * @brief   Waits for the LCD to finish processing.
- * @details This function waits for the LCD to finish processing.
- * @return  void
+ * @details Polls the busy flag without delays and gives up after
+ *          LCD_BUSY_TIMEOUT_POLLS reads. Polls that found the LCD busy are
+ *          added to lcd_busy_polls.
+ * @return  LCD_OK, or LCD_ERR_TIMEOUT if the busy flag never cleared.
  */
-void BUSY_WAIT(void);
-long int hex_to_int(const char *hex_str);
+uint8_t BUSY_WAIT(void);
+long int hex_to_int(char *hex_str);
 /**
  * @brief   Initializes the LCD.
  * @details This function initializes the LCD.
@@ -30,13 +83,6 @@ void init_lcd(void);
  */
 void INIT_TIME(void);
 
-/**
- * @brief   Gets the hexadecimal value of a character.
- * @details This function gets the hexadecimal value of a character.
- * @return  The hexadecimal value of the character.
- */
-unsigned char get_hex_value(void);
-
 /**
  * @brief   Sets the cursor to the specified address on the LCD.
  * @param   addr: The address to set the cursor to.
@@ -54,6 +100,8 @@ void lcdgotoxy(unsigned char row, unsigned char column);
 
 /**
  * @brief   Creates a custom character on the LCD.
+ * @details Writes the CGRAM address once and the eight rows through
+ *          auto-increment.
  * @param   code: The code for the custom character.
  * @param   rows: An array of row values for the custom character.
  * @return  void
@@ -77,6 +125,146 @@ void lcdputstr(char *ss);
 
 void print_board_name(void);
 
+/**
+ * @brief   Maps a DDRAM address to its cell in the shadow buffer.
+ * @param   addr: The DDRAM address.
+ * @return  The cell (row * 16 + column), or LCD_NO_CELL if off screen.
+ */
+uint8_t lcd_addr_to_cell(uint8_t addr);
+
+/**
+ * @brief   Maps a shadow buffer cell to its DDRAM address.
+ * @param   cell: The cell, 0 to 63.
+ * @return  The DDRAM address.
+ */
+uint8_t lcd_cell_to_addr(uint8_t cell);
+
+/**
+ * @brief   Fills the shadow buffer with blanks and clears the dirty bits.
+ * @details Called whenever the panel itself is cleared.
+ * @return  void
+ */
+void lcd_shadow_reset(void);
+
+/**
+ * @brief   Writes a character into the shadow buffer.
+ * @details The cell is marked dirty only if the character changes.
+ * @param   addr: The DDRAM address of the cell.
+ * @param   cc: The character.
+ * @return  void
+ */
+void lcd_fb_putch(uint8_t addr, char cc);
+
+/**
+ * @brief   Writes a string into the shadow buffer, wrapping row 3 to row 0.
+ * @param   addr: The DDRAM address of the first character.
+ * @param   ss: The string.
+ * @return  void
+ */
+void lcd_fb_putstr(uint8_t addr, char *ss);
+
+/**
+ * @brief   Finds the CGRAM characters the shadow buffer shows.
+ * @details Codes 8 to 15 count as their aliases 0 to 7.
+ * @return  Bit n set if some cell holds character code n.
+ */
+uint8_t lcd_shadow_glyphs(void);
+
+/**
+ * @brief   Sends the dirty cells of the shadow buffer to the panel.
+ * @details A set-DDRAM-address command is issued only where auto-increment
+ *          cannot reach the next dirty cell. The cursor is restored after.
+ * @return  The number of characters written.
+ */
+uint8_t lcd_flush(void);
+
+/**
+ * @brief   Returns the DDRAM address after addr, following the row order
+ *          0, 1, 2, 3 used when typing on the panel.
+ * @param   addr: The current DDRAM address.
+ * @return  The next DDRAM address.
+ */
+uint8_t lcd_next_addr(uint8_t addr);
+
+/**
+ * @brief   Empties the write queue.
+ * @details The tick raises DEFER_LCD while bytes are queued, and the
+ *          deferred handler writes them.
+ * @return  void
+ */
+void lcd_queue_init(void);
+
+/**
+ * @brief   Writes the oldest queued byte if the LCD is not busy.
+ * @details The DEFER_LCD handler. Code that has to wait for the queue calls
+ *          it directly, as the handler cannot run until it returns.
+ * @return  void
+ */
+void lcd_queue_service(void);
+
+/**
+ * @brief   Queues an instruction byte.
+ * @param   cmd: The instruction.
+ * @return  void
+ */
+void lcd_queue_cmd(uint8_t cmd);
+
+/**
+ * @brief   Queues a data byte for the current DDRAM or CGRAM address.
+ * @param   value: The byte.
+ * @return  void
+ */
+void lcd_queue_data(uint8_t value);
+
+/**
+ * @brief   Queues a set-DDRAM-address instruction.
+ * @param   addr: The DDRAM address.
+ * @return  void
+ */
+void lcd_queue_goto(uint8_t addr);
+
+/**
+ * @brief   Queues a string starting at addr and updates the shadow buffer.
+ * @param   addr: The DDRAM address of the first character.
+ * @param   ss: The string.
+ * @return  void
+ */
+void lcd_queue_putstr(uint8_t addr, char *ss);
+
+/**
+ * @brief   Queues the eight rows of a custom character.
+ * @param   code: The character code, 0 to 7.
+ * @param   rows: The eight row patterns.
+ * @return  void
+ */
+void lcd_queue_custom_char(uint8_t code, uint8_t *rows);
+
+/**
+ * @brief   Checks whether every queued byte has been written.
+ * @return  1 if the queue is empty, otherwise 0.
+ */
+uint8_t lcd_queue_idle(void);
+
+/**
+ * @brief   Returns how many bytes are waiting in the write queue.
+ * @return  0 to LCD_QUEUE_SIZE - 1.
+ */
+uint8_t lcd_queue_fill(void);
+
+/**
+ * @brief   Sets a function to call when the queue runs empty.
+ * @param   callback: The function, or 0 for none.
+ * @return  void
+ */
+void lcd_queue_on_done(void (*callback)(void));
+
+/**
+ * @brief   Waits until the queue is empty and the LCD is not busy.
+ * @details Drains the queue directly if interrupts are masked.
+ * @return  void
+ */
+void lcd_sync(void);
+
 /**
  * @brief   Reads the address of the LCD.
  * @param   is_ddram: Indicates whether to read from the DDRAM or CGRAM.
@@ -87,28 +275,29 @@ uint8_t read_lcd_address(uint8_t is_ddram, uint8_t address);
 
 /**
  * @brief   Writes a character to the LCD.
- * @details This function writes a character to the LCD.
+ * @details Prints the prompt; the console task passes the character in.
  * @return  void
  */
 void handler_wr_c_lcd(void);
 
 /**
  * @brief   Writes a string to the LCD.
- * @details This function writes a string to the LCD.
+ * @details Prints the prompt; the console task passes the string in up to
+ *          the enter key.
  * @return  void
  */
 void handler_wr_str_lcd(void);
 
 /**
  * @brief   Sets the cursor position on the LCD.
- * @details This function sets the cursor position on the LCD.
+ * @details Prints the prompt; the console task passes the row and column in.
  * @return  void
  */
 void handler_lcdgotoxy(void);
 
 /**
  * @brief   Sets the cursor address on the LCD.
- * @details This function sets the cursor address on the LCD.
+ * @details Prints the prompt; the console task passes the hex address in.
  * @return  void
  */
 void handler_lcdgotoaddress(void);
@@ -139,13 +328,32 @@ void handler_reset_time(void);
 
 /**
  * @brief   Dumps the contents of the LCD to the UART console.
- * @details This function dumps the contents of the LCD to the UART console.
+ * @details DDRAM and CGRAM are read into XRAM in one auto-increment pass
+ *          each, with interrupts enabled, and then printed.
  */
 void handler_lcd_hexdump(void);
 
+/**
+ * @brief   Reads consecutive LCD bytes after one set-address command.
+ * @param   set_addr: The set-DDRAM (0x80 | addr) or set-CGRAM (0x40 | addr)
+ *          instruction.
+ * @param   buf: Where to store the bytes.
+ * @param   n: The number of bytes.
+ * @return  void
+ */
+void lcd_read_block(uint8_t set_addr, __xdata uint8_t *buf, uint8_t n);
+
+/**
+ * @brief   Prints the LCD busy-wait statistics to the UART console.
+ * @details Shows the busy polls, the time they represent, the timeouts,
+ *          how long after boot the LCD became ready and the glyph cache use.
+ */
+void handler_lcd_stats(void);
+
 /**
  * @brief   Handles custom character creation.
- * @details This function handles custom character creation.
+ * @details Prints the first prompt; the console task passes the code, the
+ *          eight rows and the co-ordinates in.
  */
 void handler_custom_char(void);
 
@@ -158,10 +366,19 @@ void handle_cu_custom_char(void);
 
 /**
  * @brief   Gets the cursor address.
- * @details This function gets the cursor address.
+ * @details Returns the software copy of the address counter; the panel is
+ *          not read. With writes queued this is where the cursor will be
+ *          once the queue drains.
  * @return  The cursor address.
  */
 uint8_t get_cursor_address();
+
+/**
+ * @brief   Reads the address counter from the panel into the software copy.
+ * @details Waits for the write queue to drain first.
+ * @return  The cursor address.
+ */
+uint8_t lcd_cursor_resync(void);
 void print_board_name(void);
 
 #endif // _LCD_H_
@@ -0,0 +1,54 @@
+// Author: Lokesh Senthil Kumar
+// lcd_bus.c file drives the HD44780 on the memory-mapped 8-bit bus
+
+#include <stdint.h>
+#include "at89c51ed2.h"
+
+#include "timebase.h"
+#include "lcd.h"
+#include "lcd_hw.h"
+
+// Pin definitions for the LCD
+#define RS P1_2
+#define RW P1_3
+
+// The address used to read LCD commands
+#define LCD_COMMAND_READ_ADDRESS    (uint8_t *)0xF000
+
+// The LCD read pointer
+volatile uint8_t __at(LCD_COMMAND_READ_ADDRESS) lcd_ptr;
+
+void lcd_hw_init(void)
+{
+    // Send 0x30 to the LCD; the busy flag cannot be read until the third one
+    lcd_hw_write(LCD_RS_INSTRUCTION, 0x30);
+    delay_us(LCD_INIT_WAIT1_US);
+    lcd_hw_write(LCD_RS_INSTRUCTION, 0x30);
+    delay_us(LCD_INIT_WAIT2_US);
+    lcd_hw_write(LCD_RS_INSTRUCTION, 0x30);
+    BUSY_WAIT();
+
+    lcd_hw_write(LCD_RS_INSTRUCTION, LCD_FUNCTION_SET);
+    BUSY_WAIT();
+}
+
+void lcd_hw_write(uint8_t rs, uint8_t value)
+{
+    RS = rs;
+    RW = 0;
+    lcd_ptr = value;
+}
+
+uint8_t lcd_hw_read(uint8_t rs)
+{
+    RS = rs;
+    RW = 1;
+    return lcd_ptr;
+}
+
+uint8_t lcd_hw_busy(void)
+{
+    RS = 0;
+    RW = 1;
+    return (lcd_ptr & 0x80) ? 1 : 0;
+}
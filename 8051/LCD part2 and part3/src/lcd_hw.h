@@ -0,0 +1,60 @@
+// Author: Lokesh Senthil Kumar
+// lcd_hw.h file declares the HD44780 bus backends used by lcd.c
+
+#ifndef _LCD_HW_H_
+#define _LCD_HW_H_
+
+#include <stdint.h>
+
+/*
+ * The backend is chosen at build time: make LCD_BACKEND=I2C defines
+ * LCD_BACKEND_I2C and selects the PCF8574 backpack, otherwise the panel is
+ * on the memory-mapped 8-bit bus at 0xF000.
+ *
+ * Throughput per character at 11.0592 MHz:
+ *  - Bus: one MOVX write plus a busy-flag read, about 45 us, limited by the
+ *    HD44780's 37 us write time.
+ *  - I2C: one transaction of address + 4 expander bytes (two nibbles, each
+ *    strobed with E high then low), 47 SCL clocks at ~25 us each in
+ *    standard mode, about 1.2 ms. Every transaction outlasts the 37 us
+ *    write time, so the busy flag is never polled; clear and home
+ *    (1.52 ms) wait with delay_us.
+ */
+#define LCD_RS_INSTRUCTION  0
+#define LCD_RS_DATA         1
+
+#ifdef LCD_BACKEND_I2C
+#define LCD_FUNCTION_SET    0x28        // 4-bit, 2 lines, 5x8
+#else
+#define LCD_FUNCTION_SET    0x38        // 8-bit, 2 lines, 5x8
+#endif
+
+/**
+ * @brief   Runs the power-on reset sequence up to the function set.
+ * @details The caller has already waited the power-on time.
+ * @return  void
+ */
+void lcd_hw_init(void);
+
+/**
+ * @brief   Writes an instruction or data byte without waiting.
+ * @param   rs: LCD_RS_INSTRUCTION or LCD_RS_DATA.
+ * @param   value: The byte.
+ * @return  void
+ */
+void lcd_hw_write(uint8_t rs, uint8_t value);
+
+/**
+ * @brief   Reads the status (busy flag and address counter) or a data byte.
+ * @param   rs: LCD_RS_INSTRUCTION for the status, LCD_RS_DATA for data.
+ * @return  The byte.
+ */
+uint8_t lcd_hw_read(uint8_t rs);
+
+/**
+ * @brief   Checks whether the controller is still executing.
+ * @return  1 if busy, otherwise 0.
+ */
+uint8_t lcd_hw_busy(void);
+
+#endif // _LCD_HW_H_
@@ -0,0 +1,125 @@
+// Author: Lokesh Senthil Kumar
+// lcd_i2c.c file drives the HD44780 through a PCF8574 I2C backpack in 4-bit mode
+
+#include <stdint.h>
+#include "at89c51ed2.h"
+
+#include "timebase.h"
+#include "i2c.h"
+#include "lcd.h"
+#include "lcd_hw.h"
+
+/*
+ * The bus is the shared bit-banged master in common/i2c.c, built on P1.6/P1.7
+ * by the Makefile. Every byte's ACK is checked and a transaction ends at the
+ * first NACK, so a missing or misaddressed backpack only costs the address
+ * byte; i2c_nacks counts them.
+ */
+
+// 8-bit write address, set with make LCD_I2C_ADDR=. PCF8574A boards answer
+// at 0x70 to 0x7E (0x7E with A2-A0 open), PCF8574 boards at 0x40 to 0x4E.
+#ifndef LCD_I2C_ADDR
+#define LCD_I2C_ADDR        0x7E
+#endif
+
+// Backpack wiring: P0 RS, P1 RW, P2 E, P3 backlight, P4-P7 D4-D7
+#define LCD_I2C_RS          0x01
+#define LCD_I2C_RW          0x02
+#define LCD_I2C_EN          0x04
+#define LCD_I2C_BL          0x08
+
+// Clear and home need 1.52 ms, longer than a transaction
+#define LCD_I2C_SLOW_US     1600
+
+// Addresses the backpack, 1 if it answered
+static uint8_t lcd_i2c_begin(uint8_t rw)
+{
+    i2c_start();
+    return i2c_write(LCD_I2C_ADDR | rw) == I2C_ACK;
+}
+
+// One nibble for the 8-bit reset sequence, strobed in its own transaction
+static void lcd_i2c_nibble(uint8_t nibble)
+{
+    uint8_t out = (nibble << 4) | LCD_I2C_BL;
+
+    if (lcd_i2c_begin(0) && i2c_write(out | LCD_I2C_EN) == I2C_ACK) {
+        i2c_write(out);
+    }
+    i2c_stop();
+}
+
+// Raises E with D7-D4 released and reads the nibble the LCD drives
+static uint8_t lcd_i2c_read_nibble(uint8_t ctrl)
+{
+    uint8_t value = 0xFF;
+
+    if (lcd_i2c_begin(0) && i2c_write(0xF0 | ctrl) == I2C_ACK) {
+        i2c_write(0xF0 | ctrl | LCD_I2C_EN);
+    }
+    i2c_stop();
+    if (lcd_i2c_begin(I2C_READ)) {
+        value = i2c_read(I2C_NACK);
+    }
+    i2c_stop();
+    return value & 0xF0;
+}
+
+void lcd_hw_init(void)
+{
+    // 8-bit reset sequence on D7-D4, then switch to 4-bit
+    lcd_i2c_nibble(0x03);
+    delay_us(LCD_INIT_WAIT1_US);
+    lcd_i2c_nibble(0x03);
+    delay_us(LCD_INIT_WAIT2_US);
+    lcd_i2c_nibble(0x03);
+    delay_us(LCD_INIT_WAIT2_US);
+    lcd_i2c_nibble(0x02);
+    delay_us(LCD_INIT_WAIT2_US);
+
+    lcd_hw_write(LCD_RS_INSTRUCTION, LCD_FUNCTION_SET);
+    BUSY_WAIT();
+}
+
+void lcd_hw_write(uint8_t rs, uint8_t value)
+{
+    uint8_t ctrl = LCD_I2C_BL | (rs ? LCD_I2C_RS : 0);
+    uint8_t high = (value & 0xF0) | ctrl;
+    uint8_t low = (value << 4) | ctrl;
+
+    // Both nibbles and their enable strobes in one transaction
+    if (lcd_i2c_begin(0) &&
+        i2c_write(high | LCD_I2C_EN) == I2C_ACK &&
+        i2c_write(high) == I2C_ACK &&
+        i2c_write(low | LCD_I2C_EN) == I2C_ACK) {
+        i2c_write(low);
+    }
+    i2c_stop();
+
+    if (!rs && value <= 0x03) {
+        delay_us(LCD_I2C_SLOW_US);  // clear or home, not sent from the queue
+    }
+}
+
+uint8_t lcd_hw_read(uint8_t rs)
+{
+    uint8_t ctrl = LCD_I2C_BL | LCD_I2C_RW | (rs ? LCD_I2C_RS : 0);
+    uint8_t high, low;
+
+    // D7-D4 high so the expander pins can be pulled by the LCD
+    high = lcd_i2c_read_nibble(ctrl);
+    low = lcd_i2c_read_nibble(ctrl);
+
+    if (lcd_i2c_begin(0)) {
+        i2c_write(0xF0 | ctrl);     // E low again
+    }
+    i2c_stop();
+
+    return high | (low >> 4);
+}
+
+uint8_t lcd_hw_busy(void)
+{
+    // Every instruction is done before the next transaction can start
+    return 0;
+}
@@ -0,0 +1,166 @@
+// Author: Lokesh Senthil Kumar
+// mirror.c file copies the LCD contents to an ANSI terminal incrementally
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "uart.h"
+#include "lcd.h"
+#include "timebase.h"
+#include "mirror.h"
+
+// Owned by lcd.c
+extern __xdata char lcd_shadow[LCD_CELLS];
+extern volatile uint8_t lcd_shadow_gen;
+
+// What the terminal shows, 0 forces a cell to be sent
+__xdata char mirror_sent[LCD_CELLS];
+
+uint8_t mirror_on = 0;
+uint8_t mirror_gen = 0;
+uint16_t mirror_period_ms = 1000 / MIRROR_FPS_DEFAULT;
+__xdata uint32_t mirror_next_frame;
+
+// Bytes sent to the terminal, to compare against a full dump
+__xdata uint32_t mirror_bytes = 0;
+
+static void mirror_putc(char cc)
+{
+    putchar(cc);
+    mirror_bytes++;
+}
+
+// ESC [ row ; col H, written without printf
+static void mirror_goto(uint8_t row, uint8_t col)
+{
+    mirror_putc(0x1B);
+    mirror_putc('[');
+    if (row >= 10) {
+        mirror_putc('0' + row / 10);
+    }
+    mirror_putc('0' + row % 10);
+    mirror_putc(';');
+    if (col >= 100) {
+        mirror_putc('0' + col / 100);
+    }
+    if (col >= 10) {
+        mirror_putc('0' + (col / 10) % 10);
+    }
+    mirror_putc('0' + col % 10);
+    mirror_putc('H');
+}
+
+// Terminal-safe form of an LCD character code
+static char mirror_printable(char cc)
+{
+    if ((uint8_t)cc < 0x08) {
+        return '#';             // CGRAM glyph
+    }
+    if ((uint8_t)cc < 0x20 || (uint8_t)cc > 0x7E) {
+        return '?';
+    }
+    return cc;
+}
+
+// Border and a blank cell copy so the next frame sends every cell
+static void mirror_frame(void)
+{
+    for (uint8_t row = 0; row < LCD_ROWS + 2; row++) {
+        mirror_goto(MIRROR_TERM_ROW + row, MIRROR_TERM_COL);
+        mirror_putc((row == 0 || row == LCD_ROWS + 1) ? '+' : '|');
+        if (row == 0 || row == LCD_ROWS + 1) {
+            for (uint8_t col = 0; col < LCD_COLUMNS; col++) {
+                mirror_putc('-');
+            }
+            mirror_putc('+');
+        } else {
+            mirror_goto(MIRROR_TERM_ROW + row, MIRROR_TERM_COL + LCD_COLUMNS + 1);
+            mirror_putc('|');
+        }
+    }
+    for (uint8_t i = 0; i < LCD_CELLS; i++) {
+        mirror_sent[i] = 0;
+    }
+}
+
+void mirror_set_fps(uint8_t fps)
+{
+    if (fps == 0) {
+        fps = 1;
+    }
+    if (fps > MIRROR_FPS_MAX) {
+        fps = MIRROR_FPS_MAX;
+    }
+    mirror_period_ms = 1000 / fps;
+}
+
+static uint8_t mirror_fps_key(char ch)
+{
+    putchar(ch);
+    mirror_set_fps((ch >= '1' && ch <= '9') ? ch - '0' : MIRROR_FPS_DEFAULT);
+    printf("\n\r");
+
+    mirror_bytes = 0;
+    mirror_putc(0x1B);
+    mirror_putc('7');           // save the terminal cursor
+    mirror_frame();
+    mirror_putc(0x1B);
+    mirror_putc('8');
+    mirror_gen = lcd_shadow_gen - 1;    // first poll sends everything
+    mirror_next_frame = millis();
+    mirror_on = 1;
+    return UART_READ_DONE;
+}
+
+void handler_mirror(void)
+{
+    if (mirror_on) {
+        mirror_on = 0;
+        printf("Mirror off, %lu bytes sent\n\r", mirror_bytes);
+        return;
+    }
+
+    printf("Frames per second (1-9): ");
+    uart_read_with(mirror_fps_key);
+}
+
+void mirror_poll(void)
+{
+    uint8_t saved = 0;
+    uint8_t run = 0;            // 1 while the terminal cursor follows the cells
+    uint8_t gen = lcd_shadow_gen;
+    char cc;
+
+    if (!mirror_on || gen == mirror_gen || !timebase_expired(mirror_next_frame)) {
+        return;
+    }
+    mirror_next_frame = timebase_deadline(mirror_period_ms);
+    mirror_gen = gen;
+
+    for (uint8_t i = 0; i < LCD_CELLS; i++) {
+        if ((i & (LCD_COLUMNS - 1)) == 0) {
+            run = 0;            // new row, the cursor must be placed again
+        }
+        cc = mirror_printable(lcd_shadow[i]);
+        if (cc == mirror_sent[i]) {
+            run = 0;
+            continue;
+        }
+        if (!saved) {
+            mirror_putc(0x1B);
+            mirror_putc('7');   // keep the console cursor where it was
+            saved = 1;
+        }
+        if (!run) {
+            mirror_goto(MIRROR_TERM_ROW + 1 + i / LCD_COLUMNS,
+                        MIRROR_TERM_COL + 1 + (i & (LCD_COLUMNS - 1)));
+            run = 1;
+        }
+        mirror_putc(cc);
+        mirror_sent[i] = cc;
+    }
+    if (saved) {
+        mirror_putc(0x1B);
+        mirror_putc('8');
+    }
+}
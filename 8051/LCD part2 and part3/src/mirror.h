@@ -0,0 +1,42 @@
+// Author: Lokesh Senthil Kumar
+// mirror.h file declares the LCD mirror on the serial console
+
+#ifndef _MIRROR_H_
+#define _MIRROR_H_
+
+#include <stdint.h>
+
+/*
+ * The mirror draws a framed 16x4 copy of the LCD shadow buffer at a fixed
+ * place on an ANSI terminal. Each frame sends a cursor position and the run
+ * of characters only where cells changed since the last frame, and frames
+ * are limited to the set rate. Glyph codes 0-7 show as '#', other codes the
+ * terminal cannot print as '?'.
+ */
+#define MIRROR_TERM_ROW     2       // terminal row of the top border
+#define MIRROR_TERM_COL     60      // terminal column of the left border
+#define MIRROR_FPS_DEFAULT  5
+#define MIRROR_FPS_MAX      20
+
+/**
+ * @brief   Turns the mirror on (with a full redraw) or off.
+ * @details Asks for the frame rate, 1 to 9 frames per second.
+ * @return  void
+ */
+void handler_mirror(void);
+
+/**
+ * @brief   Sets the frame rate limit.
+ * @param   fps: Frames per second, clamped to 1 to MIRROR_FPS_MAX.
+ * @return  void
+ */
+void mirror_set_fps(uint8_t fps);
+
+/**
+ * @brief   Sends the cells that changed if the mirror is on and a frame is due.
+ * @details Called from the main loop.
+ * @return  void
+ */
+void mirror_poll(void);
+
+#endif // _MIRROR_H_
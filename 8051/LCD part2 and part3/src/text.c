@@ -0,0 +1,202 @@
+// Author: Lokesh Senthil Kumar
+// text.c file scrolls and pages long text on the LCD through the shadow buffer
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "uart.h"
+#include "lcd.h"
+#include "swtimer.h"
+#include "clock.h"
+#include "freq.h"
+#include "text.h"
+
+// Virtual rows and their lengths
+__xdata char text_rows[TEXT_VROWS][TEXT_LINE_MAX];
+__xdata uint8_t text_len[TEXT_VROWS];
+
+// Scroll state per virtual row, a row scrolls while its timer is armed
+__xdata uint8_t text_offset[TEXT_VROWS];
+__xdata swtimer_t text_timers[TEXT_VROWS];
+
+// First virtual row on the panel
+uint8_t text_top = 0;
+
+// Panel rows holding text drawn by this layer, one bit per row
+uint8_t text_drawn = 0;
+
+// Columns of a panel row the text may use, from column 0
+static uint8_t text_width(uint8_t prow)
+{
+    uint8_t clock_cell = lcd_addr_to_cell(CLOCK_LCD_ADDR);
+
+    if (prow == clock_cell / LCD_COLUMNS) {
+        return clock_cell % LCD_COLUMNS;        // stop short of the clock
+    }
+    if (prow == lcd_addr_to_cell(FREQ_LCD_ADDR) / LCD_COLUMNS && freq_on_lcd()) {
+        return 0;                               // the readout has the row
+    }
+    return LCD_COLUMNS;
+}
+
+// Stage the visible window of a virtual row into its panel row
+static void text_render(uint8_t vrow)
+{
+    uint8_t prow, addr, width, len, span, pos;
+
+    if (vrow < text_top || vrow >= text_top + LCD_ROWS) {
+        return;                 // not on the current page
+    }
+
+    prow = vrow - text_top;
+    addr = lcd_cell_to_addr(prow * LCD_COLUMNS);
+    width = text_width(prow);
+
+    if (text_len[vrow] == 0) {
+        // Unused: wipe what the text left there, then leave the row alone
+        if (text_drawn & (1 << prow)) {
+            for (uint8_t col = 0; col < width; col++) {
+                lcd_fb_putch(addr + col, ' ');
+            }
+            text_drawn &= ~(1 << prow);
+        }
+        return;
+    }
+
+    len = text_len[vrow];
+    span = len + TEXT_GAP;      // one scroll cycle, text then blanks
+    pos = text_offset[vrow];
+
+    text_drawn |= 1 << prow;
+    for (uint8_t col = 0; col < width; col++) {
+        lcd_fb_putch(addr + col, (pos < len) ? text_rows[vrow][pos] : ' ');
+        if (++pos >= span) {
+            pos = 0;
+        }
+    }
+}
+
+// Timer callback: move a visible row one column on
+static void text_step(uint8_t vrow)
+{
+    if (vrow < text_top || vrow >= text_top + LCD_ROWS) {
+        return;                 // off the page, resume where it stopped
+    }
+    if (++text_offset[vrow] >= text_len[vrow] + TEXT_GAP) {
+        text_offset[vrow] = 0;
+    }
+    text_render(vrow);
+    lcd_flush();
+}
+
+void text_init(void)
+{
+    for (uint8_t i = 0; i < TEXT_VROWS; i++) {
+        text_len[i] = 0;
+        text_offset[i] = 0;
+        swtimer_stop(&text_timers[i]);
+    }
+    text_top = 0;
+    text_drawn = 0;
+}
+
+void text_set_row(uint8_t vrow, char *ss)
+{
+    uint8_t len = 0;
+
+    if (vrow >= TEXT_VROWS) {
+        return;
+    }
+    while (ss[len] != '\0' && len < TEXT_LINE_MAX) {
+        text_rows[vrow][len] = ss[len];
+        len++;
+    }
+    text_len[vrow] = len;
+    text_offset[vrow] = 0;
+
+    text_render(vrow);
+    lcd_flush();
+}
+
+void text_scroll(uint8_t vrow, uint16_t period_ms)
+{
+    if (vrow >= TEXT_VROWS) {
+        return;
+    }
+    if (text_len[vrow] <= text_width(vrow % LCD_ROWS)) {
+        period_ms = 0;          // fits, nothing to scroll
+    }
+    if (period_ms) {
+        swtimer_start(&text_timers[vrow], period_ms, period_ms, text_step, vrow);
+        return;
+    }
+    swtimer_stop(&text_timers[vrow]);
+    if (text_offset[vrow]) {
+        text_offset[vrow] = 0;
+        text_render(vrow);
+        lcd_flush();
+    }
+}
+
+void text_show_page(uint8_t page)
+{
+    if (page >= TEXT_VROWS / LCD_ROWS) {
+        return;
+    }
+    text_top = page * LCD_ROWS;
+    for (uint8_t i = text_top; i < text_top + LCD_ROWS; i++) {
+        text_render(i);
+    }
+    lcd_flush();
+}
+
+void text_next_page(void)
+{
+    uint8_t page = text_top / LCD_ROWS + 1;
+
+    text_show_page((page < TEXT_VROWS / LCD_ROWS) ? page : 0);
+}
+
+// Row typed at the first prompt, 0 while it is still awaited
+__xdata char text_row_ch;
+__xdata char text_line[TEXT_LINE_MAX + 1];
+__xdata uint8_t text_line_len;
+
+static uint8_t text_row_key(char ch)
+{
+    if (!text_row_ch) {
+        putchar(ch);
+        if (ch < '0' || ch >= '0' + TEXT_VROWS) {
+            printf("\n\rInvalid row\n\r");
+            return UART_READ_DONE;
+        }
+        text_row_ch = ch;
+        printf("\n\rEnter text, up to %d characters: ", TEXT_LINE_MAX);
+        return UART_READ_MORE;
+    }
+
+    if (ch != '\r') {
+        putchar(ch);
+        text_line[text_line_len] = ch;
+        if (text_line_len < TEXT_LINE_MAX) {
+            text_line_len++;
+        }
+        return UART_READ_MORE;
+    }
+    text_line[text_line_len] = '\0';
+
+    ch = text_row_ch;
+    text_set_row(ch - '0', text_line);
+    text_scroll(ch - '0', TEXT_SCROLL_MS);
+    text_show_page((ch - '0') / LCD_ROWS);   // bring the row into view
+    printf("\n\rRow %c set\n\r", ch);
+    return UART_READ_DONE;
+}
+
+void handler_text_row(void)
+{
+    printf("\n\rEnter virtual row (0-%d): ", TEXT_VROWS - 1);
+    text_row_ch = 0;
+    text_line_len = 0;
+    uart_read_with(text_row_key);
+}
@@ -0,0 +1,70 @@
+// Author: Lokesh Senthil Kumar
+// text.h file declares the scrolling and paged text layer for the LCD
+
+#ifndef _TEXT_H_
+#define _TEXT_H_
+
+#include <stdint.h>
+
+/*
+ * Text is kept in virtual rows longer than the 16 visible columns. The panel
+ * shows one page of LCD_ROWS virtual rows at a time. A row longer than the
+ * panel can scroll: its software timer moves it one column per period and
+ * restages only that row in the shadow buffer, so a ticker costs one flush
+ * per step.
+ * The text never draws over the clock (end of row 3), and it stays off row 2
+ * while the frequency readout is on the LCD. An empty virtual row blanks
+ * what the text drew on its panel row before and otherwise leaves the row to
+ * its other owners.
+ */
+#define TEXT_VROWS          8       // two pages of four rows
+#define TEXT_LINE_MAX       64      // characters per virtual row
+#define TEXT_GAP            4       // blank columns between scroll repeats
+#define TEXT_SCROLL_MS      300     // default scroll step
+
+/**
+ * @brief   Empties every virtual row and shows page 0.
+ * @return  void
+ */
+void text_init(void);
+
+/**
+ * @brief   Sets the text of a virtual row and draws it if visible.
+ * @details Text beyond TEXT_LINE_MAX is cut. The scroll position restarts.
+ * @param   vrow: The virtual row, 0 to TEXT_VROWS - 1.
+ * @param   ss: The text.
+ * @return  void
+ */
+void text_set_row(uint8_t vrow, char *ss);
+
+/**
+ * @brief   Starts or stops scrolling a virtual row.
+ * @details Rows that fit on the panel are never scrolled.
+ * @param   vrow: The virtual row.
+ * @param   period_ms: Milliseconds per column, or 0 to stop and go back to
+ *          the start of the text.
+ * @return  void
+ */
+void text_scroll(uint8_t vrow, uint16_t period_ms);
+
+/**
+ * @brief   Shows a page of LCD_ROWS virtual rows.
+ * @param   page: The page, 0 to TEXT_VROWS / LCD_ROWS - 1.
+ * @return  void
+ */
+void text_show_page(uint8_t page);
+
+/**
+ * @brief   Shows the next page, wrapping to page 0.
+ * @return  void
+ */
+void text_next_page(void);
+
+/**
+ * @brief   Asks for a virtual row and a line of text on the UART console.
+ * @details The row scrolls at TEXT_SCROLL_MS if it is longer than the panel.
+ * @return  void
+ */
+void handler_text_row(void);
+
+#endif // _TEXT_H_
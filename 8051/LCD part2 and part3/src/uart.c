@@ -14,20 +14,43 @@
 #include<string.h>
 
 #include "lcd.h"
+#include "sched.h"
+#include "uart.h"
 
 // Define constants
 #define RX_BUFFER_SIZE 2000
 #define TX_BUFFER_SIZE 2000
 
 // Declare global variables
-extern volatile char    tenth_of_second;
-extern volatile char    seconds_ones_digit;
-extern volatile char    seconds_tens_digit;
-extern volatile char    minutes_ones_digit;
-extern volatile char    minutes_tens_digit;
-extern volatile int     update_lcd;
 extern volatile uint8_t save_cursor_address;
 
+// Console bytes from the serial ISR to the console task
+RING_DEFINE(uart_rx, uint8_t, UART_RX_SIZE, __xdata);
+
+__data uint8_t uart_rx_task = SCHED_NO_TASK;
+volatile __data uint8_t uart_tx_busy = 0;
+
+// Prompt waiting for the next characters, 0 for none
+static uart_reader_t uart_reader = 0;
+
+void uart_isr(void) __interrupt(4)
+{
+    if (RI) {
+        RI = 0;
+        if (!RING_FULL(uart_rx)) {
+            RING_PUT(uart_rx, SBUF);
+            if (uart_rx_task != SCHED_NO_TASK) {
+                SCHED_POST_FROM_ISR(uart_rx_task);
+            }
+        }
+    }
+
+    if (TI) {
+        TI = 0;
+        uart_tx_busy = 0;
+    }
+}
+
 // Initialize UART
 void uart_init()
 {
@@ -36,26 +59,53 @@ void uart_init()
     TMOD |= 0x20;   
     TH1 = 0xFD;     
     TL1 = 0xFD;     
+    RI = 0;
     TI = 0;         
-    SBUF = 0;       
+    uart_tx_busy = 0;
     TR1 = 1;        
-    ES = 1;         
+    ES = 1;         // Both directions run on the serial interrupt
     EA = 1;         
 }
 
-// Send a character over UART
+// Send a character over UART, waiting only for the byte before it
 int putchar (int c) {
-    while (!TI);    
+    // Test and claim the transmitter with the ISR held off
+    while (1) {
+        ES = 0;
+        if (!uart_tx_busy) {
+            break;
+        }
+        ES = 1;
+    }
+    uart_tx_busy = 1;
     SBUF = c;       
-    TI = 0;         
+    ES = 1;
     return c;
 }
 
 int getchar (void)
 {
-    while (!RI);    
-    RI = 0;         
-    return SBUF;    
+    uint8_t c;
+
+    while (RING_EMPTY(uart_rx));
+    RING_GET(uart_rx, c);
+    return c;    
+}
+
+void uart_read_with(uart_reader_t reader)
+{
+    uart_reader = reader;
+}
+
+uint8_t uart_read_key(char c)
+{
+    if (!uart_reader) {
+        return 0;
+    }
+    if (uart_reader(c) == UART_READ_DONE) {
+        uart_reader = 0;
+    }
+    return 1;
 }
 
 
@@ -75,6 +125,12 @@ void UI(void)
     printf("| ---  [J] -  Load CU LOGO              --------------|\r\n");
     printf("| ---  [X] -  Clear LCD          --------------|\r\n");
     printf("| ---  [P] -  BOARD NAME                --------------|\r\n");
+    printf("| ---  [K] -  Frequency Counter (P1.4)  --------------|\r\n");
+    printf("| ---  [M] -  Text Row (scrolls if long)  ------------|\r\n");
+    printf("| ---  [N] -  Next Text Page            --------------|\r\n");
+    printf("| ---  [W] -  Dashboard On/Off          --------------|\r\n");
+    printf("| ---  [V] -  Mirror LCD On/Off         --------------|\r\n");
+    printf("| ---  [S] -  LCD Statistics            --------------|\r\n");
     printf("| ---  [L] -  UI                      --------------|\r\n");
 
     printf("-------------------------------------------------------\r\n");
@@ -5,17 +5,45 @@
 #ifndef _UART_H_
 #define _UART_H_
 
+#include <stdint.h>
+#include "ring.h"
 
+/*
+ * The serial ISR queues received bytes in uart_rx and posts uart_rx_task.
+ * A handler that needs more input does not wait for it: it prints its
+ * prompt and passes a reader to uart_read_with(), and the console task
+ * hands that reader each following character until it returns
+ * UART_READ_DONE.
+ */
+#define UART_RX_SIZE        32
+
+#define UART_READ_MORE      0
+#define UART_READ_DONE      1
+
+typedef uint8_t (*uart_reader_t)(char c);
+
+RING_EXTERN(uart_rx, uint8_t, UART_RX_SIZE, __xdata);
+
+// Task posted when a byte arrives, SCHED_NO_TASK for none
+extern __data uint8_t uart_rx_task;
+
+/**
+ * @brief   Serial ISR for the console.
+ * @details The prototype must stay visible to main.c for the vector table.
+ */
+void uart_isr(void) __interrupt(4);
 
 /**
  * @brief   Initializes the UART timer.
- * @details This function initializes the UART timer with a baud rate of 9600.
+ * @details This function initializes the UART timer with a baud rate of 9600
+ *          and enables the serial interrupt.
  */
 void uart_init();
 
 /**
  * @brief   Reads a character from the UART console.
- * @details This function reads a character from the UART console.
+ * @details Waits for the serial ISR to queue one. The console task reads
+ *          uart_rx itself and never calls this.
  * @return  The character read from the UART console.
  */
 int getchar(void);
@@ -28,6 +56,21 @@ int getchar(void);
  */
 int putchar(int c);
 
+/**
+ * @brief   Sends the following console characters to a prompt's reader.
+ * @param   reader: Called once per character, returns UART_READ_DONE when
+ *          the prompt is answered.
+ * @return  void
+ */
+void uart_read_with(uart_reader_t reader);
+
+/**
+ * @brief   Passes a character to the waiting reader, if there is one.
+ * @param   c: The character.
+ * @return  1 if a reader took it, 0 if it is a command.
+ */
+uint8_t uart_read_key(char c);
+
 
 void UI(void);
 
@@ -0,0 +1,178 @@
+// Author: Lokesh Senthil Kumar
+// widget.c file draws bar graphs and big digits from CGRAM glyphs
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lcd.h"
+#include "glyph.h"
+#include "timebase.h"
+#include "widget.h"
+
+// Strokes of the big digits, top row then bottom row, three cells each
+#define BT  GLYPH_BIG_TOP
+#define BB  GLYPH_BIG_BOTTOM
+#define BO  GLYPH_BIG_BOTH
+#define FB  0xFE                // full block, ROM character
+#define SP  0xFD                // blank
+
+static __code uint8_t widget_big_font[10][2][WIDGET_BIG_WIDTH] = {
+    {{FB, BT, FB}, {FB, BB, FB}},   // 0
+    {{BT, FB, SP}, {BB, FB, BB}},   // 1
+    {{BO, BO, FB}, {FB, BB, BB}},   // 2
+    {{BO, BO, FB}, {BB, BB, FB}},   // 3
+    {{FB, BB, FB}, {SP, SP, FB}},   // 4
+    {{FB, BO, BO}, {BB, BB, FB}},   // 5
+    {{FB, BO, BO}, {FB, BB, FB}},   // 6
+    {{BT, BT, FB}, {SP, SP, FB}},   // 7
+    {{FB, BO, FB}, {FB, BB, FB}},   // 8
+    {{FB, BO, FB}, {BB, BB, FB}},   // 9
+};
+
+// Dashboard state
+uint8_t widget_dash_on = 0;
+__xdata uint32_t widget_dash_next;
+__xdata widget_bar_t widget_dash_bar;
+__xdata widget_big_t widget_dash_big;
+
+// Character code for a glyph, or a ROM stand-in when no slot is free
+static char widget_glyph(uint8_t id)
+{
+    uint8_t code = glyph_acquire(id);
+
+    return (code == GLYPH_NO_SLOT) ? WIDGET_NO_GLYPH : code;
+}
+
+// Character code for one stroke
+static char widget_stroke(uint8_t stroke)
+{
+    if (stroke == FB) {
+        return WIDGET_FULL_BLOCK;
+    }
+    if (stroke == SP) {
+        return ' ';
+    }
+    return widget_glyph(stroke);
+}
+
+// Blanks cells along one row
+static void widget_blank(uint8_t addr, uint8_t cells)
+{
+    for (uint8_t i = 0; i < cells; i++) {
+        lcd_fb_putch(addr + i, ' ');
+    }
+}
+
+void widget_bar_init(widget_bar_t *bar, uint8_t addr, uint8_t cells, uint16_t max)
+{
+    bar->addr = addr;
+    bar->cells = cells;
+    bar->max = max ? max : 1;
+    bar->drawn = 0xFF;
+}
+
+void widget_bar_set(widget_bar_t *bar, uint16_t value)
+{
+    uint8_t lit, cell_lit;
+    uint8_t partial = 0xFF;
+    uint8_t step = 0;
+    char cc;
+
+    if (value > bar->max) {
+        value = bar->max;
+    }
+    lit = ((uint32_t)value * bar->cells * WIDGET_BAR_STEPS + bar->max / 2) / bar->max;
+    if (lit == bar->drawn) {
+        return;
+    }
+    bar->drawn = lit;
+
+    for (uint8_t i = 0; i < bar->cells; i++) {
+        cell_lit = (lit > WIDGET_BAR_STEPS) ? WIDGET_BAR_STEPS : lit;
+        lit -= cell_lit;
+        if (cell_lit == WIDGET_BAR_STEPS) {
+            cc = WIDGET_FULL_BLOCK;
+        } else if (cell_lit == 0) {
+            cc = ' ';
+        } else {
+            // Blank for now so the old step glyph is off screen
+            partial = i;
+            step = cell_lit;
+            cc = ' ';
+        }
+        lcd_fb_putch(bar->addr + i, cc);    // unchanged cells stay clean
+    }
+
+    if (partial != 0xFF) {
+        lcd_fb_putch(bar->addr + partial, widget_glyph(GLYPH_BAR_1 + step - 1));
+    }
+}
+
+void widget_big_init(widget_big_t *big, uint8_t addr, uint8_t digits)
+{
+    big->addr = addr;
+    big->digits = (digits > WIDGET_BIG_MAX) ? WIDGET_BIG_MAX : digits;
+    big->drawn = 0xFFFFFFFF;
+}
+
+void widget_big_set(widget_big_t *big, uint32_t value)
+{
+    uint32_t old = big->drawn;
+    uint8_t top = big->addr;
+    uint8_t bottom = lcd_cell_to_addr(lcd_addr_to_cell(top) + LCD_COLUMNS);
+    uint8_t col, digit;
+
+    if (value == old) {
+        return;
+    }
+    big->drawn = value;
+
+    // Right to left, skipping digits that are already on the panel
+    for (uint8_t i = big->digits; i > 0; i--) {
+        digit = value % 10;
+        value /= 10;
+        if (old != 0xFFFFFFFF && digit == old % 10) {
+            old /= 10;
+            continue;
+        }
+        old /= 10;
+
+        col = (i - 1) * WIDGET_BIG_WIDTH;
+        for (uint8_t j = 0; j < WIDGET_BIG_WIDTH; j++) {
+            lcd_fb_putch(top + col + j, widget_stroke(widget_big_font[digit][0][j]));
+            lcd_fb_putch(bottom + col + j, widget_stroke(widget_big_font[digit][1][j]));
+        }
+    }
+}
+
+void handler_dashboard(void)
+{
+    widget_dash_on = !widget_dash_on;
+    if (widget_dash_on) {
+        widget_big_init(&widget_dash_big, WIDGET_DASH_BIG_ADDR, WIDGET_DASH_BIG_DIGITS);
+        widget_bar_init(&widget_dash_bar, WIDGET_DASH_BAR_ADDR, WIDGET_DASH_BAR_CELLS,
+                        LCD_QUEUE_SIZE - 1);
+        widget_dash_next = millis();
+        printf("Dashboard on: uptime (s) and LCD queue fill\n\r");
+    } else {
+        // Blank both rows of digits and the bar, releasing their glyphs
+        widget_blank(WIDGET_DASH_BIG_ADDR, WIDGET_DASH_BIG_DIGITS * WIDGET_BIG_WIDTH);
+        widget_blank(lcd_cell_to_addr(lcd_addr_to_cell(WIDGET_DASH_BIG_ADDR) + LCD_COLUMNS),
+                     WIDGET_DASH_BIG_DIGITS * WIDGET_BIG_WIDTH);
+        widget_blank(WIDGET_DASH_BAR_ADDR, WIDGET_DASH_BAR_CELLS);
+        lcd_flush();
+        printf("Dashboard off\n\r");
+    }
+}
+
+void widget_poll(void)
+{
+    if (!widget_dash_on || !timebase_expired(widget_dash_next)) {
+        return;
+    }
+    widget_dash_next += WIDGET_DASH_MS;
+
+    widget_big_set(&widget_dash_big, millis() / 1000);
+    widget_bar_set(&widget_dash_bar, lcd_queue_fill());
+    lcd_flush();
+}
@@ -0,0 +1,99 @@
+// Author: Lokesh Senthil Kumar
+// widget.h file declares the bar graph and big digit widgets for the LCD
+
+#ifndef _WIDGET_H_
+#define _WIDGET_H_
+
+#include <stdint.h>
+
+/*
+ * Widgets draw through the glyph cache and the shadow buffer. Each one keeps
+ * the value it last drew and returns at once when it has not changed; when it
+ * has, only the cells that differ reach the panel on the next lcd_flush.
+ *
+ * CGRAM budget: a bar shows at most one partial cell, so one bar step glyph,
+ * and big digits use three strokes. A bar and a big number on screen together
+ * hold four of the eight slots, which leaves four for the logo or custom
+ * characters. The glyph cache never evicts a slot still on screen; when it
+ * refuses, the cell shows WIDGET_NO_GLYPH instead. A full cell is the ROM
+ * block character 0xFF.
+ */
+#define WIDGET_FULL_BLOCK   0xFF
+#define WIDGET_NO_GLYPH     '#'
+#define WIDGET_BAR_STEPS    5       // columns lit per cell
+#define WIDGET_BIG_WIDTH    3       // columns per big digit
+#define WIDGET_BIG_MAX      5       // digits per big number
+
+/* Dashboard layout: big uptime seconds on rows 0-1, queue bar on row 3 */
+#define WIDGET_DASH_BIG_ADDR    0x00
+#define WIDGET_DASH_BIG_DIGITS  4
+#define WIDGET_DASH_BAR_ADDR    0x50
+#define WIDGET_DASH_BAR_CELLS   8
+#define WIDGET_DASH_MS          200
+
+typedef struct {
+    uint8_t addr;           // DDRAM address of the first cell
+    uint8_t cells;          // width in cells
+    uint16_t max;           // value that fills the bar
+    uint8_t drawn;          // lit columns last drawn, 0xFF before the first
+} widget_bar_t;
+
+typedef struct {
+    uint8_t addr;           // DDRAM address of the top-left cell, rows 0-2
+    uint8_t digits;         // 1 to WIDGET_BIG_MAX
+    uint32_t drawn;         // value last drawn, 0xFFFFFFFF before the first
+} widget_big_t;
+
+/**
+ * @brief   Sets up a bar graph.
+ * @param   bar: The widget.
+ * @param   addr: The DDRAM address of its first cell.
+ * @param   cells: Its width in cells.
+ * @param   max: The value that fills it.
+ * @return  void
+ */
+void widget_bar_init(widget_bar_t *bar, uint8_t addr, uint8_t cells, uint16_t max);
+
+/**
+ * @brief   Stages a bar graph value with five steps per cell.
+ * @param   bar: The widget.
+ * @param   value: The value, clamped to max.
+ * @return  void
+ */
+void widget_bar_set(widget_bar_t *bar, uint16_t value);
+
+/**
+ * @brief   Sets up a two-row big number.
+ * @param   big: The widget.
+ * @param   addr: The DDRAM address of its top-left cell, on rows 0 to 2.
+ * @param   digits: The number of digits.
+ * @return  void
+ */
+void widget_big_init(widget_big_t *big, uint8_t addr, uint8_t digits);
+
+/**
+ * @brief   Stages a big number, leading zeros shown.
+ * @details Only digits that changed are restaged.
+ * @param   big: The widget.
+ * @param   value: The value.
+ * @return  void
+ */
+void widget_big_set(widget_big_t *big, uint32_t value);
+
+/**
+ * @brief   Turns the live dashboard on or off.
+ * @details Shows the uptime in seconds as big digits and the LCD write queue
+ *          fill as a bar graph. Turning it off blanks its cells, which frees
+ *          its glyphs.
+ * @return  void
+ */
+void handler_dashboard(void);
+
+/**
+ * @brief   Refreshes the dashboard when it is on and due.
+ * @details Called from the main loop.
+ * @return  void
+ */
+void widget_poll(void);
+
+#endif // _WIDGET_H_
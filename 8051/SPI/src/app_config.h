@@ -0,0 +1,39 @@
+// Author: Lokesh Senthil Kumar
+// app_config.h file sets this program's options for the shared modules in ../common
+
+#ifndef _APP_CONFIG_H_
+#define _APP_CONFIG_H_
+
+/* ---- irq.h: interrupt sources; costs are estimates, see irq.h ---- */
+
+/* Longest stretch the foreground keeps a source masked */
+#define IRQ_CRITICAL_US     15
+
+/* Timer 0, DAC samples: waiting shows up as sample jitter on both outputs */
+#define IRQ_TIMER0_COST_US      60
+#define IRQ_TIMER0_BUDGET_US    100
+#define IRQ_TIMER0_MEASURED     1
+
+/*
+ * PCA, PWM samples: CCAPnH must be written before the next PWM period. With
+ * CH reloaded to 0xFF the handler runs once per 256-count PWM period, 3600
+ * times a second, so this row is a real 278 us source: about 40 us of every
+ * period, and the budget leaves room for Timer 0 on the same level.
+ */
+#define IRQ_PCA_COST_US         40
+#define IRQ_PCA_BUDGET_US       100
+#define IRQ_PCA_MEASURED        1
+
+/* Serial, console and sample stream: SBUF must be read before the next byte (1 ms) */
+#define IRQ_SERIAL_COST_US      30
+#define IRQ_SERIAL_BUDGET_US    500
+#define IRQ_SERIAL_MEASURED     0
+
+/* Timer 2, 1 ms tick: only has to finish inside the tick */
+#define IRQ_TIMER2_COST_US      20
+#define IRQ_TIMER2_BUDGET_US    900
+#define IRQ_TIMER2_MEASURED     1
+
+#define IRQ_LIST(X, arg)    X(TIMER0, arg) X(PCA, arg) X(SERIAL, arg) X(TIMER2, arg)
+
+#endif // _APP_CONFIG_H_
@@ -0,0 +1,356 @@
+// Author: Lokesh Senthil Kumar
+// dac.c file drives the two MCP48x2 DAC channels over the hardware SPI
+
+#include "at89c51ed2.h"
+#include "mcs51reg.h"
+#include <stdint.h>
+#include <stdio.h>
+#include "dac.h"
+#include "settings.h"
+#include "startup.h"
+#include "pwm.h"
+#include "swtimer.h"
+
+/* Wave Data  */
+STARTUP_TABLE uint8_t static sine_wave[DAC_TABLE_SIZE] = {
+    128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174,
+    177, 180, 182, 185, 188, 191, 194, 196, 199, 201, 204, 206, 209, 211, 214, 216,
+    217, 215, 212, 210, 208, 205, 203, 200, 197, 195, 192, 189, 187, 184, 181, 178,
+    175, 172, 169, 167, 164, 160, 157, 154, 151, 148, 145, 142, 139, 136, 133, 130,
+    126, 123, 120, 117, 114, 111, 108, 105, 102,  99,  96,  92,  89,  87,  84,  81,
+     78,  75,  72,  69,  67,  64,  61,  59,  56,  53,  51,  48,  46,  44,  41,  39,
+     40,  42,  45,  47,  50,  52,  55,  57,  60,  62,  65,  68,  71,  74,  76,  79,
+     82,  85,  88,  91,  94,  97, 100, 103, 106, 109, 112, 116, 119, 122, 125, 128,
+};
+
+static const char * __code wave_names[DAC_WAVE_COUNT] = {
+    "Sine", "Square", "Triangle", "Sawtooth"
+};
+
+/* Global Variables */
+__xdata dac_channel_t dac_channels[DAC_CHANNELS];
+
+// Ready-to-send command words, one period per channel, in two pages
+__xdata uint16_t dac_word_pages[2][DAC_CHANNELS][DAC_TABLE_SIZE];
+
+// The same period as CCAPnH values for the PWM backend
+__xdata uint8_t dac_pwm_pages[2][DAC_CHANNELS][DAC_TABLE_SIZE];
+
+// Page each channel is playing, and the pointers the ISRs read it through
+__xdata uint8_t dac_live_page[DAC_CHANNELS];
+__xdata uint16_t * volatile __data dac_table[DAC_CHANNELS];
+__xdata uint8_t * volatile __data dac_pwm_table[DAC_CHANNELS];
+
+volatile uint8_t dac_backend = DAC_BACKEND_SPI;
+
+// Phase accumulators, advanced by the Timer 0 ISR
+volatile __data uint16_t dac_phase[DAC_CHANNELS];
+
+// Frequency sweep, one 1 Hz step each time the timer fires
+__xdata swtimer_t dac_sweep_timer;
+__xdata uint16_t dac_sweep_hz;
+__xdata uint16_t dac_sweep_end;
+
+//SPI configuration initialization
+void spi_init(void) {
+    SPCON |= 0x10;   // Master mode
+    P1_1=1;
+    SPCON |= 0x82;   // Fclk Periph / 128
+    SPCON &= ~0x08;  // CPOL = 0
+    SPCON |= 0x04;   // CPHA = 1
+    SPCON |= 0x40;   // Enable SPI
+    SPCON |= 0x20;
+    
+    ldac_bar = 1;    // Hold the outputs until both channels are loaded
+}
+
+/**
+ * @brief Send a 16-bit command word to the DAC via SPI.
+ * 
+ * @param command_word The 16-bit data to send.
+ */
+void spi_send_word(uint16_t command_word) {
+    uint8_t high_byte = (command_word >> 8) & 0xFF;
+    uint8_t low_byte = command_word & 0xFF;
+
+    // Send high byte
+    SPDAT = high_byte;
+    while (!(SPSTA & 0x80));  // Wait for transmission to complete
+    SPSTA &= ~0x80;           // Clear interrupt flag
+
+    // Send low byte
+    SPDAT = low_byte;
+    while (!(SPSTA & 0x80));  // Wait for transmission to complete
+    SPSTA &= ~0x80;           // Clear interrupt flag
+}
+
+// Control bits of a channel's command word
+static uint16_t dac_control_bits(uint8_t channel)
+{
+    uint16_t control = DAC_ACTIVE_mask;
+
+    if (channel == DAC_CHANNEL_B) {
+        control |= DAC_SELECT_B_mask;
+    }
+    if (dac_channels[channel].gain == 1) {
+        control |= DAC_GAIN_1X_mask;
+    }
+    return control;
+}
+
+// Sample i of one period of the given waveform, 0 to 255
+static uint8_t wave_sample(uint8_t waveform, uint8_t i)
+{
+    switch (waveform) {
+        case DAC_WAVE_SQUARE:
+            return (i < DAC_TABLE_SIZE / 2) ? 0xFF : 0x00;
+        case DAC_WAVE_TRIANGLE:
+            return (i < DAC_TABLE_SIZE / 2) ? (i << 2) : ((DAC_TABLE_SIZE - 1 - i) << 2);
+        case DAC_WAVE_SAWTOOTH:
+            return i << 1;
+        default:
+            return sine_wave[i];
+    }
+}
+
+/*
+ * Amplitude and offset are folded in here so the ISR only fetches words.
+ * Each sample is centred on 128, scaled by amplitude/256 with a
+ * multiply-shift into the 12-bit range (x16 >> 8 = >> 4), offset and clamped.
+ */
+void dac_build_table(uint8_t channel)
+{
+    uint16_t control = dac_control_bits(channel);
+    uint8_t waveform = dac_channels[channel].waveform;
+    uint8_t amplitude = dac_channels[channel].amplitude;
+    int16_t offset = dac_channels[channel].offset;
+    uint8_t page = dac_live_page[channel] ^ 1;
+    __xdata uint16_t *words = dac_word_pages[page][channel];
+    __xdata uint8_t *duties = dac_pwm_pages[page][channel];
+    int16_t code;
+
+    for (uint8_t i = 0; i < DAC_TABLE_SIZE; i++) {
+        code = ((int16_t)wave_sample(waveform, i) - 128) * amplitude;
+        code = offset + (code >> 4);
+        if (code < 0) {
+            code = 0;
+        } else if (code > DAC_MAX_CODE) {
+            code = DAC_MAX_CODE;
+        }
+        words[i] = (uint16_t)code | control;
+
+        // The PWM pin is high once CL reaches CCAPnL, so the top 8 bits of
+        // the code are inverted to get a duty cycle of (code + 1) / 256
+        duties[i] = 0xFF - (uint8_t)(code >> 4);
+    }
+
+    // Two-byte pointers, so no ISR may run between the halves
+    __critical {
+        dac_table[channel] = words;
+        dac_pwm_table[channel] = duties;
+    }
+    dac_live_page[channel] = page;
+}
+
+void dac_sync_phases(void)
+{
+    __critical {
+        dac_phase[DAC_CHANNEL_A] = dac_channels[DAC_CHANNEL_A].phase_offset;
+        dac_phase[DAC_CHANNEL_B] = dac_channels[DAC_CHANNEL_B].phase_offset;
+    }
+}
+
+void dac_init(void)
+{
+    uint8_t restored = settings_load();
+
+    for (uint8_t ch = 0; ch < DAC_CHANNELS; ch++) {
+        if (!restored) {
+            dac_channels[ch].waveform = DAC_WAVE_SINE;
+            dac_channels[ch].gain = 1;
+            dac_channels[ch].step = DAC_DEFAULT_STEP;
+            dac_channels[ch].phase_offset = 0;
+            dac_channels[ch].amplitude = DAC_DEFAULT_AMPLITUDE;
+            dac_channels[ch].offset = DAC_DEFAULT_OFFSET;
+        }
+        dac_build_table(ch);
+    }
+    dac_sync_phases();
+}
+
+/**
+ * Write one sample to Channel A.
+ */
+void dac_write_sample(uint8_t sample) {
+
+    uint16_t command_word = ((uint16_t)sample << 4) | dac_control_bits(DAC_CHANNEL_A);
+
+    cs_bar = 0;               // Select the DAC
+    spi_send_word(command_word);  // Send the command
+    cs_bar = 1;               // Deselect the DAC
+
+    ldac_bar = 0;             // Transfer to the output
+    ldac_bar = 1;
+}
+
+/**
+ * Update the DAC output for both channels.
+ */
+void dac_update_output(void) {
+
+    // Load channel A then channel B into the input registers
+    cs_bar = 0;
+    spi_send_word(dac_table[DAC_CHANNEL_A][dac_phase[DAC_CHANNEL_A] >> DAC_PHASE_SHIFT]);
+    cs_bar = 1;
+
+    cs_bar = 0;
+    spi_send_word(dac_table[DAC_CHANNEL_B][dac_phase[DAC_CHANNEL_B] >> DAC_PHASE_SHIFT]);
+    cs_bar = 1;
+
+    // Latch both outputs on the same edge
+    ldac_bar = 0;
+    ldac_bar = 1;
+
+    // Advance the waveforms
+    dac_phase[DAC_CHANNEL_A] += dac_channels[DAC_CHANNEL_A].step;
+    dac_phase[DAC_CHANNEL_B] += dac_channels[DAC_CHANNEL_B].step;
+}
+
+/* Gain Control Functions */
+void dac_increase_voltage(uint8_t channel) {
+    if (dac_channels[channel].gain < 2) {
+        dac_channels[channel].gain++;
+        dac_build_table(channel);
+        settings_save();
+    }
+}
+
+void dac_decrease_voltage(uint8_t channel) {
+    if (dac_channels[channel].gain > 1) {
+        dac_channels[channel].gain--;
+        dac_build_table(channel);
+        settings_save();
+    }
+}
+
+void dac_next_waveform(uint8_t channel)
+{
+    dac_channels[channel].waveform = (dac_channels[channel].waveform + 1) % DAC_WAVE_COUNT;
+    dac_build_table(channel);
+    settings_save();
+}
+
+void dac_set_backend(uint8_t backend)
+{
+    if (backend == DAC_BACKEND_PWM) {
+        TR0 = 0;                // SPI sample timer off
+        SPCON &= ~0x40;         // Release P1.5 from the SPI for CEX2
+        dac_backend = DAC_BACKEND_PWM;
+        pwm_start();
+    } else {
+        pwm_stop();
+        SPCON |= 0x40;          // Enable SPI
+        dac_backend = DAC_BACKEND_SPI;
+        TR0 = 1;
+    }
+}
+
+// Change the phase step of a channel without saving the settings
+static void dac_apply_frequency(uint8_t channel, uint16_t hz)
+{
+    uint16_t step = (uint16_t)(((uint32_t)hz << 16) / WAVE_SAMPLE_RATE);
+
+    __critical {
+        dac_channels[channel].step = step;    // Read by the Timer 0 ISR
+        pwm_step[channel] = step / PWM_RATE_MULTIPLE;
+    }
+}
+
+void dac_set_frequency(uint8_t channel, uint16_t hz)
+{
+    // A sweep on the other channel keeps running
+    if (dac_sweep_timer.arg == channel) {
+        dac_sweep_stop();
+    }
+    dac_apply_frequency(channel, hz);
+    settings_save();
+}
+
+// Timer callback: move the swept channel 1 Hz towards the end frequency
+static void dac_sweep_step(uint8_t channel)
+{
+    if (dac_sweep_hz < dac_sweep_end) {
+        dac_sweep_hz++;
+    } else if (dac_sweep_hz > dac_sweep_end) {
+        dac_sweep_hz--;
+    }
+    dac_apply_frequency(channel, dac_sweep_hz);
+    if (dac_sweep_hz == dac_sweep_end) {
+        swtimer_stop(&dac_sweep_timer);
+        settings_save();                        // Keep the end frequency
+        printf("\n\rSweep done at %u Hz", dac_sweep_hz);
+    }
+}
+
+void dac_sweep_start(uint8_t channel, uint16_t from_hz, uint16_t to_hz, uint16_t step_ms)
+{
+    dac_sweep_hz = from_hz;
+    dac_sweep_end = to_hz;
+    dac_apply_frequency(channel, from_hz);
+    if (from_hz == to_hz) {
+        swtimer_stop(&dac_sweep_timer);
+        settings_save();
+        return;
+    }
+    swtimer_start(&dac_sweep_timer, step_ms, step_ms, dac_sweep_step, channel);
+}
+
+void dac_sweep_stop(void)
+{
+    if (swtimer_active(&dac_sweep_timer)) {
+        swtimer_stop(&dac_sweep_timer);
+        settings_save();                        // Keep where it stopped
+    }
+}
+
+uint8_t dac_sweep_running(void)
+{
+    return swtimer_active(&dac_sweep_timer);
+}
+
+void dac_set_phase(uint8_t channel, uint16_t degrees)
+{
+    dac_channels[channel].phase_offset = (uint16_t)(((uint32_t)degrees << 16) / 360);
+    dac_sync_phases();
+    settings_save();
+}
+
+void dac_set_amplitude(uint8_t channel, uint8_t amplitude)
+{
+    dac_channels[channel].amplitude = amplitude;
+    dac_build_table(channel);
+    settings_save();
+}
+
+void dac_set_offset(uint8_t channel, uint16_t offset)
+{
+    dac_channels[channel].offset = offset;
+    dac_build_table(channel);
+    settings_save();
+}
+
+void dac_print_settings(void)
+{
+    printf("\n\rOutput: %s", dac_backend == DAC_BACKEND_PWM ? "PCA PWM (CEX1/CEX2)" : "SPI DAC");
+    for (uint8_t ch = 0; ch < DAC_CHANNELS; ch++) {
+        dac_channel_t *c = &dac_channels[ch];
+        // Frequency in hundredths of a Hz
+        uint32_t centi_hz = ((uint32_t)c->step * (WAVE_SAMPLE_RATE * 100UL)) >> 16;
+        uint16_t degrees = (uint16_t)(((uint32_t)c->phase_offset * 360) >> 16);
+
+        printf("\n\rChannel %c: %s, %lu.%02u Hz, phase %u deg, gain %ux, amplitude %u/256, offset %u",
+               'A' + ch, wave_names[c->waveform],
+               centi_hz / 100, (uint16_t)(centi_hz % 100), degrees, c->gain,
+               c->amplitude, c->offset);
+    }
+}
@@ -0,0 +1,204 @@
+// Author: Lokesh Senthil Kumar
+// dac.h file declares the MCP48x2 DAC functions used over SPI
+
+#ifndef _DAC_H_
+#define _DAC_H_
+
+#include <stdint.h>
+
+/* DAC Control Pins */
+#define cs_bar   P1_3   // Chip Select
+#define ldac_bar P1_2   // Latch DAC, pulsed low to update both outputs together
+
+/* MCP48x2 command word bits */
+#define DAC_SELECT_B_mask 0x8000   // Write channel B (clear for channel A)
+#define DAC_GAIN_1X_mask  0x2000   // 1x output gain (clear for 2x)
+#define DAC_ACTIVE_mask   0x1000   // Output enabled (clear for shutdown)
+
+/* Channels and waveforms */
+#define DAC_CHANNEL_A   0
+#define DAC_CHANNEL_B   1
+#define DAC_CHANNELS    2
+
+#define DAC_WAVE_SINE       0
+#define DAC_WAVE_SQUARE     1
+#define DAC_WAVE_TRIANGLE   2
+#define DAC_WAVE_SAWTOOTH   3
+#define DAC_WAVE_COUNT      4
+
+/* One waveform period is 128 samples; the 16-bit phase uses the top 7 bits */
+#define DAC_TABLE_SIZE      128
+#define DAC_PHASE_SHIFT     9
+
+/* Timer 0 reload for 1024 machine cycles, a 900 Hz sample rate */
+#define WAVE_RELOAD_H 0xFC
+#define WAVE_RELOAD_L 0x00
+#define WAVE_SAMPLE_RATE 900
+
+/* Phase step that walks one table entry per sample (~7 Hz) */
+#define DAC_DEFAULT_STEP    (65536UL / DAC_TABLE_SIZE)
+
+/* A sweep moves 1 Hz every DAC_SWEEP_STEP_MS */
+#define DAC_SWEEP_STEP_MS   50
+
+/* Digital level controls, applied when a table is built */
+#define DAC_MAX_CODE        4095    // Full scale of the 12-bit DAC
+#define DAC_DEFAULT_AMPLITUDE 255   // 255/256 of full swing
+#define DAC_DEFAULT_OFFSET  2048    // Mid scale
+
+/* Output backends */
+#define DAC_BACKEND_SPI     0   // MCP48x2 over SPI, Timer 0 at 900 Hz
+#define DAC_BACKEND_PWM     1   // PCA 8-bit PWM + RC filter, PCA at 3600 Hz
+
+/* Per-channel settings */
+typedef struct {
+    uint8_t  waveform;      // DAC_WAVE_*
+    uint8_t  gain;          // 1 or 2
+    uint16_t step;          // Phase increment per sample, 65536 = one period
+    uint16_t phase_offset;  // Starting phase, 65536 = 360 degrees
+    uint8_t  amplitude;     // Peak swing in 1/256ths of full scale
+    uint16_t offset;        // DC level of the waveform centre, 0 to 4095
+} dac_channel_t;
+
+extern __xdata dac_channel_t dac_channels[DAC_CHANNELS];
+
+// Each channel has two pages of tables. The ISRs play the page these
+// pointers select while dac_build_table fills the other one. The pointers
+// and the phase accumulators are used on every sample, so they sit in
+// internal RAM.
+extern __xdata uint16_t * volatile __data dac_table[DAC_CHANNELS];
+extern __xdata uint8_t * volatile __data dac_pwm_table[DAC_CHANNELS];
+extern volatile __data uint16_t dac_phase[DAC_CHANNELS];
+
+// Backend currently producing the output
+extern volatile uint8_t dac_backend;
+
+/**
+ * @brief Initializes the on-chip SPI controller as master for the DAC.
+ */
+void spi_init(void);
+
+/**
+ * @brief Send a 16-bit command word to the DAC via SPI.
+ *
+ * @param command_word The 16-bit data to send.
+ */
+void spi_send_word(uint16_t command_word);
+
+/**
+ * @brief Restores the saved channel settings, or the defaults if none are
+ *        saved, and builds both tables.
+ */
+void dac_init(void);
+
+/**
+ * @brief Switches the waveform output between the SPI DAC and PCA PWM.
+ *
+ * @param backend DAC_BACKEND_SPI or DAC_BACKEND_PWM.
+ */
+void dac_set_backend(uint8_t backend);
+
+/**
+ * @brief Rebuilds the SPI command-word and PWM duty tables of a channel
+ *        from its settings.
+ * @details Fills the page the ISRs are not playing and then swaps pages, so
+ *          the output never sees a torn word or a half-built table.
+ *
+ * @param channel DAC_CHANNEL_A or DAC_CHANNEL_B.
+ */
+void dac_build_table(uint8_t channel);
+
+/**
+ * @brief Restarts both phase accumulators at their phase offsets.
+ */
+void dac_sync_phases(void);
+
+/**
+ * @brief Writes one 8-bit sample to DAC channel A with its current gain.
+ *
+ * @param sample The sample value, scaled to the 12-bit DAC range.
+ */
+void dac_write_sample(uint8_t sample);
+
+/**
+ * @brief Loads the next sample of both channels and latches them with LDAC.
+ */
+void dac_update_output(void);
+
+/**
+ * @brief Selects the 2x output gain on a channel.
+ */
+void dac_increase_voltage(uint8_t channel);
+
+/**
+ * @brief Selects the 1x output gain on a channel.
+ */
+void dac_decrease_voltage(uint8_t channel);
+
+/**
+ * @brief Selects the next waveform on a channel.
+ */
+void dac_next_waveform(uint8_t channel);
+
+/**
+ * @brief Sets the output frequency of a channel.
+ *
+ * @param channel DAC_CHANNEL_A or DAC_CHANNEL_B.
+ * @param hz Frequency in Hz, up to half the sample rate.
+ */
+void dac_set_frequency(uint8_t channel, uint16_t hz);
+
+/**
+ * @brief Sweeps the frequency of a channel in 1 Hz steps on a software
+ *        timer. Setting the frequency of the swept channel by hand stops
+ *        the sweep.
+ *
+ * @param channel DAC_CHANNEL_A or DAC_CHANNEL_B.
+ * @param from_hz Start frequency in Hz.
+ * @param to_hz End frequency in Hz, above or below the start.
+ * @param step_ms Milliseconds per 1 Hz step.
+ */
+void dac_sweep_start(uint8_t channel, uint16_t from_hz, uint16_t to_hz, uint16_t step_ms);
+
+/**
+ * @brief Stops a running sweep at its current frequency.
+ */
+void dac_sweep_stop(void);
+
+/**
+ * @brief Tells if a sweep is running.
+ *
+ * @return 1 while sweeping, otherwise 0.
+ */
+uint8_t dac_sweep_running(void);
+
+/**
+ * @brief Sets the phase offset of a channel and resynchronizes both.
+ *
+ * @param channel DAC_CHANNEL_A or DAC_CHANNEL_B.
+ * @param degrees Phase offset, 0 to 359.
+ */
+void dac_set_phase(uint8_t channel, uint16_t degrees);
+
+/**
+ * @brief Sets the digital amplitude of a channel.
+ *
+ * @param channel DAC_CHANNEL_A or DAC_CHANNEL_B.
+ * @param amplitude Peak swing in 1/256ths of full scale, 0 to 255.
+ */
+void dac_set_amplitude(uint8_t channel, uint8_t amplitude);
+
+/**
+ * @brief Sets the DC offset of a channel.
+ *
+ * @param channel DAC_CHANNEL_A or DAC_CHANNEL_B.
+ * @param offset DAC code of the waveform centre, 0 to 4095.
+ */
+void dac_set_offset(uint8_t channel, uint16_t offset);
+
+/**
+ * @brief Prints the settings of both channels.
+ */
+void dac_print_settings(void);
+
+#endif // _DAC_H_
@@ -8,108 +8,30 @@
 #include <stdint.h>
 #include <stdio.h>
 #include "uart.h"
+#include "dac.h"
+#include "stream.h"
+#include "pwm.h"
+#include "startup.h"
+#include "timebase.h"
+#include "sched.h"
+#include "swtimer.h"
+#include "irq.h"
 
-/* DAC Control Pins */
-#define cs_bar P1_3     // Chip Select
-#define A_mask 0xF000              // DAC Channel A mask
-#define active_mask 0x3000         // Active configuration mask
-#define Gain_increase_mask 0xFFFF  // Mask for gain increase
-#define Gain_decrease_mask 0x7FFF  // Mask for gain decrease
-
-/* Wave Data  */
-__xdata uint8_t static sine_wave[128] = {
-    128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174,
-    177, 180, 182, 185, 188, 191, 194, 196, 199, 201, 204, 206, 209, 211, 214, 216,
-    217, 215, 212, 210, 208, 205, 203, 200, 197, 195, 192, 189, 187, 184, 181, 178,
-    175, 172, 169, 167, 164, 160, 157, 154, 151, 148, 145, 142, 139, 136, 133, 130,
-    126, 123, 120, 117, 114, 111, 108, 105, 102,  99,  96,  92,  89,  87,  84,  81,
-     78,  75,  72,  69,  67,  64,  61,  59,  56,  53,  51,  48,  46,  44,  41,  39,
-     40,  42,  45,  47,  50,  52,  55,  57,  60,  62,  65,  68,  71,  74,  76,  79,
-     82,  85,  88,  91,  94,  97, 100, 103, 106, 109, 112, 116, 119, 122, 125, 128,
-};
-
-
-
-/* Global Variables */
-__xdata uint16_t counter = 0;
-uint8_t gain = 1;  // Default gain setting
-
-//SPI configuration initialization
-void spi_init(void) {
-    SPCON |= 0x10;   // Master mode
-    P1_1=1;
-    SPCON |= 0x82;   // Fclk Periph / 128
-    SPCON &= ~0x08;  // CPOL = 0
-    SPCON |= 0x04;   // CPHA = 1
-    SPCON |= 0x40;   // Enable SPI
-    SPCON |= 0x20;
-    
-}
-
-/**
- * @brief Send a 16-bit command word to the DAC via SPI.
- * 
- * @param command_word The 16-bit data to send.
- */
-void spi_send_word(uint16_t command_word) {
-    uint8_t high_byte = (command_word >> 8) & 0xFF;
-    uint8_t low_byte = command_word & 0xFF;
-
-    // Send high byte
-    SPDAT = high_byte;
-    while (!(SPSTA & 0x80));  // Wait for transmission to complete
-    SPSTA &= ~0x80;           // Clear interrupt flag
-
-    // Send low byte
-    SPDAT = low_byte;
-    while (!(SPSTA & 0x80));  // Wait for transmission to complete
-    SPSTA &= ~0x80;           // Clear interrupt flag
-}
-
-/**
- * Update the DAC output for Channel A.
- */
-void dac_update_output(void) {
-   
-    uint16_t command_word = (sine_wave[counter] << 4) | A_mask | active_mask;
-
-    // Apply gain
-    if (gain == 2) {
-        command_word &= Gain_increase_mask;
-    } else {
-        command_word &= Gain_decrease_mask;
-    }
-    
-    
-    cs_bar = 0;               // Select the DAC
-    spi_send_word(command_word);  // Send the command
-    cs_bar = 1;               // Deselect the DAC
-
-    // Increment waveform counter
-    counter = (counter + 1) % 128;
-    //printf("count %d", counter);
-}
-
-/* Gain Control Functions */
-void dac_increase_voltage(void) {
-    if (gain < 2) {
-        gain++;
-    }
-}
-
-void dac_decrease_voltage(void) {
-    if (gain > 1) {
-        gain--;
-    }
-}
 
 //interrupt handler for the timer 0
 void wave_interrupt_handler(void) __interrupt(1)
 {
+    IRQ_MEASURE_TIMER0();  // Before the reload, TH0:TL0 is the entry latency
     TF0 = 0;
-    TL0 = 0x00;
-    TH0 = 0xFC;
-    dac_update_output();
+    if (stream_active) {
+        TL0 = STREAM_RELOAD_L;
+        TH0 = STREAM_RELOAD_H;
+        stream_play_sample();
+    } else {
+        TL0 = WAVE_RELOAD_L;
+        TH0 = WAVE_RELOAD_H;
+        dac_update_output();
+    }
 
 }
 
@@ -119,44 +41,223 @@ void waves_init(void)
     IEN0 |= 0x82;
     TMOD |= 0x01;
     TMOD &= 0xF1;
-    TL0 = 0x00;
-    TH0 = 0xFC;
+    TL0 = WAVE_RELOAD_L;
+    TH0 = WAVE_RELOAD_H;
     TR0 = 1;
     return;
 }
 
-/* Main Function */
-void main(void) {
-    __xdata uint8_t key_pressed;
+static void print_help(void)
+{
+    printf("\n\rCommands: \n\r'A'/'B'-> Select channel, \n\r'+'-> Increase the Voltage, \n\r'-'-> Decrease the Voltage, "
+           "\n\r'W'-> Next waveform, \n\r'F'-> Set frequency (Hz), \n\r'P'-> Set phase offset (deg), "
+           "\n\r'M'-> Set amplitude (0-255), \n\r'O'-> Set DC offset (0-4095), "
+           "\n\r'T'-> Toggle SPI DAC / PCA PWM output, \n\r'S'-> Stream samples from UART, "
+           "\n\r'G'-> Sweep frequency (again to stop), \n\r'C'-> Task statistics, \n\r'?'-> HELP");
+    dac_print_settings();
+}
 
-    initialize_UART();  // Initialize UART for user input
-    spi_init();         // Initialize SPI module
-    waves_init();
+// Channel the commands apply to
+static __xdata uint8_t channel = DAC_CHANNEL_A;
 
-    printf("\n\rWelcome to DAC Wave generator");
-    printf("\n\rCommands: \n\r'+'-> Increase the Voltage, \n\r'-'-> Decrease the Voltage, \n\r'?'-> HELP");
-
-    
-
-    while (1) {
-        //get the character to increase or decrese the voltage
-        key_pressed = getchar();
-        
-        switch (key_pressed) {
-            case '+':
-                dac_increase_voltage();
-                printf("\n\rVoltage Increased\n\r");
+/* Number the console is waiting for; typed a character per console run */
+#define PROMPT_NONE         0
+#define PROMPT_FREQUENCY    1
+#define PROMPT_PHASE        2
+#define PROMPT_AMPLITUDE    3
+#define PROMPT_OFFSET       4
+#define PROMPT_SWEEP_FROM   5
+#define PROMPT_SWEEP_TO     6
+
+static __xdata uint8_t prompt = PROMPT_NONE;
+static __xdata uint16_t sweep_from_hz;
+
+static void prompt_start(uint8_t which)
+{
+    prompt = which;
+    read_decimal_start();
+}
+
+// Acts on the number entered at the current prompt
+static void prompt_done(uint16_t value)
+{
+    uint8_t which = prompt;
+
+    prompt = PROMPT_NONE;
+    switch (which) {
+        case PROMPT_FREQUENCY:
+            if (value == 0 || value > WAVE_SAMPLE_RATE / 2) {
+                printf("\n\rInvalid Frequency");
                 break;
-            case '-':
-                dac_decrease_voltage();
-                printf("\n\rVoltage Decreased\n\r");
+            }
+            dac_set_frequency(channel, value);
+            dac_print_settings();
+            break;
+        case PROMPT_PHASE:
+            if (value > 359) {
+                printf("\n\rInvalid Phase");
                 break;
-            case '?':
-                printf("\n\rCommands: \n\r'+'-> Increase the Voltage, \n\r'-'-> Decrease the Voltage, \n\r'?'-> HELP");
+            }
+            dac_set_phase(channel, value);
+            dac_print_settings();
+            break;
+        case PROMPT_AMPLITUDE:
+            if (value > 255) {
+                printf("\n\rInvalid Amplitude");
                 break;
-            default:
-                printf("\n\rInvalid Command");
+            }
+            dac_set_amplitude(channel, value);
+            dac_print_settings();
+            break;
+        case PROMPT_OFFSET:
+            if (value > DAC_MAX_CODE) {
+                printf("\n\rInvalid Offset");
                 break;
+            }
+            dac_set_offset(channel, value);
+            dac_print_settings();
+            break;
+        case PROMPT_SWEEP_FROM:
+            sweep_from_hz = value;
+            printf("\n\rSweep to Hz (1 to %u): ", WAVE_SAMPLE_RATE / 2);
+            prompt_start(PROMPT_SWEEP_TO);
+            break;
+        case PROMPT_SWEEP_TO:
+            if (sweep_from_hz == 0 || sweep_from_hz > WAVE_SAMPLE_RATE / 2 ||
+                value == 0 || value > WAVE_SAMPLE_RATE / 2) {
+                printf("\n\rInvalid Frequency");
+                break;
+            }
+            dac_sweep_start(channel, sweep_from_hz, value, DAC_SWEEP_STEP_MS);
+            printf("\n\rSweeping %u to %u Hz, 'G' to stop", sweep_from_hz, value);
+            break;
+    }
+}
+
+// Handles one command key
+static void console_command(uint8_t key_pressed)
+{
+    switch (key_pressed) {
+        case 'A':
+        case 'a':
+            channel = DAC_CHANNEL_A;
+            printf("\n\rChannel A selected\n\r");
+            break;
+        case 'B':
+        case 'b':
+            channel = DAC_CHANNEL_B;
+            printf("\n\rChannel B selected\n\r");
+            break;
+        case '+':
+            dac_increase_voltage(channel);
+            printf("\n\rVoltage Increased\n\r");
+            break;
+        case '-':
+            dac_decrease_voltage(channel);
+            printf("\n\rVoltage Decreased\n\r");
+            break;
+        case 'W':
+        case 'w':
+            dac_next_waveform(channel);
+            dac_print_settings();
+            break;
+        case 'F':
+        case 'f':
+            printf("\n\rFrequency in Hz (1 to %u): ", WAVE_SAMPLE_RATE / 2);
+            prompt_start(PROMPT_FREQUENCY);
+            break;
+        case 'P':
+        case 'p':
+            printf("\n\rPhase offset in degrees (0 to 359): ");
+            prompt_start(PROMPT_PHASE);
+            break;
+        case 'M':
+        case 'm':
+            printf("\n\rAmplitude (0 to 255): ");
+            prompt_start(PROMPT_AMPLITUDE);
+            break;
+        case 'O':
+        case 'o':
+            printf("\n\rDC offset (0 to %u): ", DAC_MAX_CODE);
+            prompt_start(PROMPT_OFFSET);
+            break;
+        case 'T':
+        case 't':
+            dac_set_backend(dac_backend == DAC_BACKEND_SPI ? DAC_BACKEND_PWM : DAC_BACKEND_SPI);
+            dac_print_settings();
+            break;
+        case 'S':
+        case 's':
+            if (dac_backend != DAC_BACKEND_SPI) {
+                printf("\n\rStreaming needs the SPI DAC output");
+                break;
+            }
+            stream_start();     // The stream task takes it from here
+            break;
+        case 'G':
+        case 'g':
+            if (dac_sweep_running()) {
+                dac_sweep_stop();
+                dac_print_settings();
+                break;
+            }
+            printf("\n\rSweep from Hz (1 to %u): ", WAVE_SAMPLE_RATE / 2);
+            prompt_start(PROMPT_SWEEP_FROM);
+            break;
+        case 'C':
+        case 'c':
+            sched_print_stats();
+            swtimer_print_stats();
+            irq_print_stats();
+            break;
+        case '?':
+            print_help();
+            break;
+        default:
+            printf("\n\rInvalid Command");
+            break;
+    }
+}
+
+/**
+ * @brief   Handles the characters the serial ISR has queued.
+ * @details Posted by the serial ISR; never waits for the line.
+ * @return  void
+ */
+static void console_task(void)
+{
+    __xdata uint8_t c;
+
+    // Once a stream starts, the bytes that follow are samples
+    while (!RING_EMPTY(uart_rx) && !stream_active) {
+        RING_GET(uart_rx, c);
+        if (prompt == PROMPT_NONE) {
+            console_command(c);
+        } else if (read_decimal_feed(c)) {
+            prompt_done(read_decimal_value);
         }
     }
-}
\ No newline at end of file
+}
+
+/* Main Function */
+void main(void) {
+    startup_time_us();  // Before anything else touches Timer 2
+
+    irq_init();         // Priority levels from the latency budgets (irq.h)
+    initialize_UART();  // Initialize UART for user input
+    timebase_init();    // 1 ms tick for the scheduler
+    swtimer_init();     // Software timers on the same tick
+    spi_init();         // Initialize SPI module
+    dac_init();         // Build both channel tables
+    waves_init();
+
+    printf("\n\rWelcome to DAC Wave generator");
+    printf("\n\rC startup: ");
+    startup_print();
+    print_help();
+
+    sched_add("timers", swtimer_poll, 1);
+    uart_rx_task = sched_add("console", console_task, 0);
+    stream_init();
+    sched_run();
+}
@@ -0,0 +1,57 @@
+// Author: Lokesh Senthil Kumar
+// pwm.c file plays the waveform tables on the PCA PWM outputs
+
+#include "at89c51ed2.h"
+#include "mcs51reg.h"
+#include <stdint.h>
+#include "dac.h"
+#include "pwm.h"
+#include "irq.h"
+
+// Phase increments at the PWM sample rate
+volatile __data uint16_t pwm_step[DAC_CHANNELS];
+
+void pca_isr(void) __interrupt(6) __using(IRQ_BANK(PCA))
+{
+    IRQ_NOTE_LATENCY(IRQ_PCA_VECTOR, CL);  // CL counts machine cycles from the overflow
+    CH = PCA_CH_RELOAD;     // Interrupt again after 256 counts, not 65536
+    CF = 0;
+
+    // CCAPnH is copied to CCAPnL at the next overflow, so both channels
+    // change together without an LDAC equivalent
+    CCAP1H = dac_pwm_table[DAC_CHANNEL_A][dac_phase[DAC_CHANNEL_A] >> DAC_PHASE_SHIFT];
+    CCAP2H = dac_pwm_table[DAC_CHANNEL_B][dac_phase[DAC_CHANNEL_B] >> DAC_PHASE_SHIFT];
+
+    dac_phase[DAC_CHANNEL_A] += pwm_step[DAC_CHANNEL_A];
+    dac_phase[DAC_CHANNEL_B] += pwm_step[DAC_CHANNEL_B];
+}
+
+void pwm_start(void)
+{
+    // Same frequency at four times the sample rate
+    pwm_step[DAC_CHANNEL_A] = dac_channels[DAC_CHANNEL_A].step / PWM_RATE_MULTIPLE;
+    pwm_step[DAC_CHANNEL_B] = dac_channels[DAC_CHANNEL_B].step / PWM_RATE_MULTIPLE;
+
+    CR = 0;
+    CMOD = PCA_CMOD_FOSC_12 | PCA_CMOD_ECF;
+    CL = 0;
+    CH = PCA_CH_RELOAD;
+
+    CCAP1L = CCAP1H = dac_pwm_table[DAC_CHANNEL_A][0];
+    CCAP2L = CCAP2H = dac_pwm_table[DAC_CHANNEL_B][0];
+    CCAPM1 = PCA_CCAPM_PWM;
+    CCAPM2 = PCA_CCAPM_PWM;
+
+    CF = 0;
+    IEN0 |= PCA_IEN0_EC;
+    CR = 1;                 // Run the PCA counter
+}
+
+void pwm_stop(void)
+{
+    IEN0 &= ~PCA_IEN0_EC;
+    CR = 0;
+    CCAPM1 = 0;
+    CCAPM2 = 0;
+    CF = 0;
+}
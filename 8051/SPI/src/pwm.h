@@ -0,0 +1,48 @@
+// Author: Lokesh Senthil Kumar
+// pwm.h file declares the PCA 8-bit PWM output backend
+
+#ifndef _PWM_H_
+#define _PWM_H_
+
+#include <stdint.h>
+#include "dac.h"
+#include "irq.h"
+
+/*
+ * PCA modules 1 and 2 run in 8-bit PWM mode on CEX1 (P1.4, channel A) and
+ * CEX2 (P1.5, channel B). An RC low-pass filter on each pin gives the analog
+ * output. The PCA counts at Fosc/12, so CL overflows every 256 machine
+ * cycles: a 3600 Hz carrier. CF is only set when all of CH:CL overflows, so
+ * the ISR puts 0xFF back in CH each time and the next CL overflow carries
+ * out. That gives a 3600 Hz sample rate, four times the SPI DAC rate.
+ */
+#define PCA_CH_RELOAD       0xFF    // CH:CL overflows with the next CL overflow
+#define PWM_SAMPLE_RATE     3600
+#define PWM_RATE_MULTIPLE   (PWM_SAMPLE_RATE / WAVE_SAMPLE_RATE)
+
+#define PCA_CMOD_FOSC_12    0x00    // CPS1:0 = 00, PCA clock = Fosc/12
+#define PCA_CMOD_ECF        0x01    // Interrupt on CH:CL overflow
+#define PCA_CCAPM_PWM       0x42    // ECOM | PWM
+#define PCA_IEN0_EC         0x40    // PCA interrupt enable in IEN0
+
+/**
+ * @brief   PCA overflow interrupt; loads the next duty cycle of both channels.
+ * @details Calls nothing, so it runs on its own register bank. The prototype
+ *          must stay visible to main.c for the vector table.
+ */
+void pca_isr(void) __interrupt(6) __using(IRQ_BANK(PCA));
+
+/**
+ * @brief   Starts the PCA PWM outputs and the PCA overflow interrupt.
+ */
+void pwm_start(void);
+
+/**
+ * @brief   Stops the PCA and returns CEX1/CEX2 to port pins.
+ */
+void pwm_stop(void);
+
+// Phase increments at the PWM sample rate
+extern volatile __data uint16_t pwm_step[DAC_CHANNELS];
+
+#endif // _PWM_H_
@@ -0,0 +1,55 @@
+// Author: Lokesh Senthil Kumar
+// settings.c file keeps the DAC channel settings across resets in NVRAM
+
+#include <stdint.h>
+#include <string.h>
+#include "dac.h"
+#include "settings.h"
+
+typedef struct {
+    uint16_t magic;
+    dac_channel_t channels[DAC_CHANNELS];
+    uint8_t checksum;       // Two's complement of the byte sum before it
+} dac_settings_t;
+
+__xdata __at(SETTINGS_ADDR) dac_settings_t nv_settings;
+
+// Byte sum of everything before the checksum field
+static uint8_t settings_sum(void)
+{
+    __xdata uint8_t *p = (__xdata uint8_t *)&nv_settings;
+    uint8_t sum = 0;
+
+    for (uint8_t i = 0; i < sizeof(dac_settings_t) - 1; i++) {
+        sum += p[i];
+    }
+    return sum;
+}
+
+uint8_t settings_load(void)
+{
+    if (nv_settings.magic != SETTINGS_MAGIC ||
+        (uint8_t)(settings_sum() + nv_settings.checksum) != 0) {
+        return 0;
+    }
+
+    // Reject values a corrupted but checksum-valid block could still hold
+    for (uint8_t ch = 0; ch < DAC_CHANNELS; ch++) {
+        if (nv_settings.channels[ch].waveform >= DAC_WAVE_COUNT ||
+            nv_settings.channels[ch].gain < 1 || nv_settings.channels[ch].gain > 2 ||
+            nv_settings.channels[ch].offset > DAC_MAX_CODE) {
+            return 0;
+        }
+    }
+
+    memcpy(dac_channels, nv_settings.channels, sizeof(dac_channels));
+    return 1;
+}
+
+void settings_save(void)
+{
+    nv_settings.magic = 0;      // Invalid while the block is being written
+    memcpy(nv_settings.channels, dac_channels, sizeof(dac_channels));
+    nv_settings.magic = SETTINGS_MAGIC;
+    nv_settings.checksum = -settings_sum();
+}
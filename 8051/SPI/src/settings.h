@@ -0,0 +1,28 @@
+// Author: Lokesh Senthil Kumar
+// settings.h file declares the DAC settings kept in battery-backed NVRAM
+
+#ifndef _SETTINGS_H_
+#define _SETTINGS_H_
+
+#include <stdint.h>
+#include "startup.h"
+
+/*
+ * The settings block sits in the persistent region at the top of the 32 KB
+ * NVRAM, see startup.h.
+ */
+#define SETTINGS_ADDR   PERSIST_ADDR
+#define SETTINGS_MAGIC  0xDAC5
+
+/**
+ * @brief   Copies the saved settings into dac_channels.
+ * @return  1 if a valid block was found, 0 if the defaults must be used.
+ */
+uint8_t settings_load(void);
+
+/**
+ * @brief   Writes dac_channels to NVRAM with a fresh checksum.
+ */
+void settings_save(void);
+
+#endif // _SETTINGS_H_
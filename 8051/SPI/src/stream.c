@@ -0,0 +1,167 @@
+// Author: Lokesh Senthil Kumar
+// stream.c file streams binary samples from the UART to the DAC
+
+#include "at89c51ed2.h"
+#include "mcs51reg.h"
+#include <stdint.h>
+#include <stdio.h>
+#include "dac.h"
+#include "ring.h"
+#include "sched.h"
+#include "stream.h"
+#include "uart.h"
+
+/* Ring buffer shared by the serial ISR (producer) and Timer 0 ISR (consumer) */
+RING_DEFINE(stream_ring, uint8_t, 256, __xdata);
+
+/* Read on every sample, so they sit in internal RAM */
+volatile __data uint8_t stream_active = 0;
+volatile __data uint8_t stream_primed = 0;
+volatile __data uint8_t stream_idle_expired = 0;
+volatile __data uint16_t stream_idle_ticks = 0;
+__data uint8_t stream_prime_fill = 0;   // fill seen on the last unprimed tick
+
+/* Flow control state, owned by the serial ISR */
+volatile __data uint8_t stream_xoff = 0;
+
+// Posted by the sample ISR for XON and for the end of the stream
+__data uint8_t stream_task_id = SCHED_NO_TASK;
+
+/* Running statistics */
+__xdata uint32_t stream_bytes_received;
+__xdata uint32_t stream_samples_played;
+__xdata uint16_t stream_overruns;
+__xdata uint32_t stream_underruns;
+__xdata uint8_t  stream_peak_fill;
+__xdata uint16_t stream_xoff_count;
+
+void stream_receive(uint8_t value)
+{
+    stream_bytes_received++;
+
+    if (RING_FULL(stream_ring)) {
+        stream_overruns++;              // Ring full, drop the sample
+    } else {
+        RING_PUT(stream_ring, value);
+    }
+
+    RING_HIGH_WATER(stream_ring, stream_peak_fill);
+    if (RING_COUNT(stream_ring) >= STREAM_HIGH_WATERMARK && !stream_xoff) {
+        stream_xoff = 1;
+        stream_xoff_count++;
+        uart_send_control(STREAM_XOFF);
+    }
+}
+
+void stream_play_sample(void)
+{
+    uint8_t fill = RING_COUNT(stream_ring);
+
+    if (!stream_primed) {
+        // Nothing plays until the ring holds STREAM_PRIME_LEVEL bytes, or a
+        // shorter stream has been quiet for the idle time. Nothing is taken
+        // out yet, so a change in fill means a byte arrived.
+        if (fill != stream_prime_fill) {
+            stream_prime_fill = fill;
+            stream_idle_ticks = 0;
+        }
+        if (fill < STREAM_PRIME_LEVEL &&
+            (fill == 0 || stream_idle_ticks < STREAM_IDLE_EXIT_TICKS)) {
+            // The host may be started by hand, give it the long timeout
+            if (++stream_idle_ticks >= STREAM_START_TIMEOUT_TICKS) {
+                stream_idle_expired = 1;
+                SCHED_POST_FROM_ISR(stream_task_id);
+            }
+            return;
+        }
+        stream_primed = 1;
+    } else if (fill == 0) {
+        // Nothing to play, the DAC holds its last output
+        if (++stream_idle_ticks >= STREAM_IDLE_EXIT_TICKS) {
+            stream_idle_expired = 1;
+            SCHED_POST_FROM_ISR(stream_task_id);
+        }
+        return;
+    } else {
+        // Starved ticks only count as underruns once the host resumes, so
+        // the idle tail that ends the stream is not included
+        stream_underruns += stream_idle_ticks;
+    }
+    stream_idle_ticks = 0;
+
+    dac_write_sample(RING_PEEK(stream_ring));
+    RING_DROP(stream_ring);
+    stream_samples_played++;
+
+    if (stream_xoff && fill <= STREAM_LOW_WATERMARK) {
+        SCHED_POST_FROM_ISR(stream_task_id);    // Host may send again
+    }
+}
+
+// Return Timer 0 to the waveform and the serial port to the console
+static void stream_stop(void)
+{
+    stream_active = 0;
+    ES = 0;
+    if (stream_xoff) {
+        uart_send_control(STREAM_XON);  // Never leave the host paused
+        stream_xoff = 0;
+    }
+    ES = 1;
+}
+
+static void stream_task(void)
+{
+    if (!stream_active) {
+        return;
+    }
+
+    // XON is raised here rather than in the sample ISR to keep it short
+    ES = 0;
+    if (stream_xoff && RING_COUNT(stream_ring) <= STREAM_LOW_WATERMARK) {
+        stream_xoff = 0;
+        uart_send_control(STREAM_XON);
+    }
+    ES = 1;
+
+    if (!stream_idle_expired) {
+        return;
+    }
+    stream_stop();
+
+    printf("\n\rStreaming stopped");
+    printf("\n\rBytes received : %lu", stream_bytes_received);
+    printf("\n\rSamples played : %lu", stream_samples_played);
+    printf("\n\rOverruns       : %u", stream_overruns);
+    printf("\n\rUnderruns      : %lu", stream_underruns);
+    printf("\n\rPeak fill      : %u/255", stream_peak_fill);
+    printf("\n\rXOFF sent      : %u\n\r", stream_xoff_count);
+}
+
+void stream_init(void)
+{
+    stream_task_id = sched_add("stream", stream_task, 0);
+}
+
+void stream_start(void)
+{
+    printf("\n\rStreaming mode: send 8-bit samples, XON/XOFF flow control");
+    printf("\n\rStop sending for 0.5 s to exit, or send nothing for 30 s\n\r");
+
+    RING_RESET(stream_ring);
+    stream_primed = 0;
+    stream_prime_fill = 0;
+    stream_idle_ticks = 0;
+    stream_idle_expired = 0;
+    stream_xoff = 0;
+
+    stream_bytes_received = 0;
+    stream_samples_played = 0;
+    stream_overruns = 0;
+    stream_underruns = 0;
+    stream_peak_fill = 0;
+    stream_xoff_count = 0;
+
+    stream_active = 1;          // Received bytes are samples, Timer 0 switches rate
+    RING_RESET(uart_rx);        // Typed after the command, not commands
+}
@@ -0,0 +1,63 @@
+// Author: Lokesh Senthil Kumar
+// stream.h file declares the UART to DAC sample streaming mode
+
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+#include <stdint.h>
+
+/*
+ * The samples pass through a 256-byte ring (ring.h); the serial ISR is its
+ * producer and the Timer 0 ISR its consumer.
+ */
+#define STREAM_HIGH_WATERMARK  192     // Send XOFF at or above this fill level
+#define STREAM_LOW_WATERMARK   64      // Send XON at or below this fill level
+#define STREAM_PRIME_LEVEL     128     // Fill level needed before playback starts
+
+#define STREAM_XON             0x11
+#define STREAM_XOFF            0x13
+
+/* Timer 0 reload for 980 machine cycles, ~940 samples/s. At 9600 baud the
+   line carries 960 bytes/s, so playback runs at ~98% of the serial limit
+   and XON/XOFF absorbs the difference. */
+#define STREAM_RELOAD_H        0xFC
+#define STREAM_RELOAD_L        0x2C
+
+/* Empty-buffer sample ticks (~0.5 s) after which a started stream ends.
+   Before playback starts, the same quiet time also starts a stream shorter
+   than STREAM_PRIME_LEVEL. */
+#define STREAM_IDLE_EXIT_TICKS 470
+
+/* Sample ticks (~30 s) to wait for the first byte from the host */
+#define STREAM_START_TIMEOUT_TICKS 28200
+
+// Set while streaming; selects the stream path in the Timer 0 ISR
+extern volatile __data uint8_t stream_active;
+
+/**
+ * @brief   Takes one received sample; called from the serial ISR.
+ * @details Pushes it into the ring and sends XOFF at the high watermark.
+ */
+void stream_receive(uint8_t value);
+
+/**
+ * @brief   Plays one streamed sample; called from the Timer 0 ISR.
+ * @details Holds the last output and counts an underrun when the ring is empty.
+ *          Posts the stream task when XON is due or the stream has ended.
+ */
+void stream_play_sample(void);
+
+/**
+ * @brief   Registers the stream task with the scheduler.
+ * @return  void
+ */
+void stream_init(void);
+
+/**
+ * @brief   Starts streaming mode and returns.
+ * @details The stream task sends XON, ends the stream when the host stops
+ *          sending and prints the overrun/underrun statistics.
+ */
+void stream_start(void);
+
+#endif // _STREAM_H_
@@ -4,6 +4,10 @@
  *
  * This file provides functions to initialize the UART, send/receive characters, and perform
  * hexadecimal and integer conversions. It also includes a robust input parsing function.
+ *
+ * Both directions are interrupt driven, so no task waits on the line: received
+ * bytes are queued for the console task (or handed to the stream), and
+ * putchar only waits for the byte before it.
  */
 
 #include <stdbool.h>
@@ -15,72 +19,160 @@
 #include <at89c51ed2.h>
 #include <mcs51reg.h>
 #include <mcs51/8051.h>
+#include "sched.h"
+#include "stream.h"
+#include "uart.h"
+
+// Console bytes from the serial ISR to the console task
+RING_DEFINE(uart_rx, uint8_t, UART_RX_SIZE, __xdata);
 
+__data uint8_t uart_rx_task = SCHED_NO_TASK;
+volatile __data uint8_t uart_tx_busy = 0;
+volatile __data uint8_t uart_tx_control = 0;   // flow control byte to send next
 
+// Number being typed at a prompt
+__xdata uint16_t read_decimal_value;
+__xdata uint8_t read_decimal_digits;
+
+void uart_isr(void) __interrupt(4)
+{
+    if (RI) {
+        RI = 0;
+        if (stream_active) {
+            stream_receive(SBUF);
+        } else if (!RING_FULL(uart_rx)) {
+            RING_PUT(uart_rx, SBUF);
+            if (uart_rx_task != SCHED_NO_TASK) {
+                SCHED_POST_FROM_ISR(uart_rx_task);
+            }
+        }
+    }
+
+    if (TI) {
+        TI = 0;
+        if (uart_tx_control) {
+            SBUF = uart_tx_control;
+            uart_tx_control = 0;
+        } else {
+            uart_tx_busy = 0;
+        }
+    }
+}
 
 
 
 /**
  * @brief Receives a single character via UART.
  * 
- * Waits until a character is received, clears the receive interrupt flag, 
- * and returns the received character.
+ * Waits until the serial ISR has queued a character and returns it. The
+ * console task reads uart_rx directly instead, so it never waits.
  * 
  * @return int The received character.
  */
 int getchar (void)
 {
-    while (!RI); //Wait till the Character is received
-	RI = 0;			// Clear the RI flag
-	return SBUF;  	// Return the Character
+    uint8_t c;
+
+    while (RING_EMPTY(uart_rx)); //Wait till the Character is received
+    RING_GET(uart_rx, c);
+    return c;           // Return the Character
 }
 
 int gety(void){
-    if(RI){
-        RI = 0;			// Clear the RI flag
-	return SBUF;  	// Return the Character
+    uint8_t c = 0;
+
+    if (!RING_EMPTY(uart_rx)) {
+        RING_GET(uart_rx, c);
     }
+    return c;           // 0 if nothing arrived
 }
 
 
 /**
  * @brief Transmits a single character via UART.
  * 
- * Waits until the transmitter is ready, writes the character to the UART buffer,
- * and clears the transmit interrupt flag.
+ * Waits until the serial ISR has finished the previous byte, then writes the
+ * character to the UART buffer. Needs the serial interrupt enabled.
  * 
  * @param c The character to transmit.
  * @return int The transmitted character.
  */
 int putchar (int c)
 {
-    while(!TI); //Wait till the Transmitter is ready
+    // Test and claim the transmitter with the ISR held off, it may be
+    // sending XON/XOFF on its own
+    while (1) {
+        ES = 0;
+        if (!uart_tx_busy) {
+            break;
+        }
+        ES = 1;
+    }
+    uart_tx_busy = 1;
     SBUF = c; //write character to SBUF
-    TI = 0; //Clear the TI flag
+    ES = 1;
     return c;
 }
 
+void uart_send_control(uint8_t control)
+{
+    if (uart_tx_busy) {
+        uart_tx_control = control;      // Sent when the current byte completes
+    } else {
+        uart_tx_busy = 1;
+        SBUF = control;
+    }
+}
+
 
 /**
  * @brief Initializes the UART for 9600 baud communication.
  * 
  * Configures Timer 1 in Mode 2 (8-bit auto-reload) and UART in Mode 1 (8-bit UART).
- * Enables interrupts and prepares for data transmission.
+ * Enables the serial interrupt that both directions run on. Priorities are
+ * set by irq_init.
  */
 void initialize_UART(void)
 {
     IEN0|=0x80;
-    IPL0 |= 0x10;
     TMOD |= 0x20; //TIMER 1, MODE 2
     SCON |= 0x50; //8 BIT, 1 STOP , REN ENABLED
     TCON |= 0x40; 	//START TIMER1
     TH1 = 0xFD;
-    TI = 1;
+    RI = 0;
+    TI = 0;
+    uart_tx_busy = 0;
+    ES = 1;
 }
 
 
 
+void read_decimal_start(void)
+{
+    read_decimal_value = 0;
+    read_decimal_digits = 0;
+}
 
-
-
-
+/**
+ * @brief Adds one typed character to the number at the prompt.
+ *
+ * Echoes digits and handles backspace. Values above 65535 wrap.
+ *
+ * @param c The character.
+ * @return uint8_t 1 once a carriage return ends the number, otherwise 0.
+ */
+uint8_t read_decimal_feed(char c)
+{
+    if (c >= '0' && c <= '9' && read_decimal_digits < 5) {
+        putchar(c);
+        read_decimal_value = read_decimal_value * 10 + (c - '0');
+        read_decimal_digits++;
+    } else if (c == '\b' && read_decimal_digits > 0) {
+        putchar('\b');
+        putchar(' ');
+        putchar('\b');
+        read_decimal_value /= 10;
+        read_decimal_digits--;
+    }
+    return c == '\r';
+}
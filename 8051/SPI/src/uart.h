@@ -1,6 +1,31 @@
 #ifndef _UART_H_
 #define _UART_H_
 
+#include <stdint.h>
+#include "ring.h"
+
+/*
+ * The serial ISR owns both directions. Outside a stream it queues received
+ * bytes in uart_rx and posts uart_rx_task; putchar waits only for the byte
+ * before it. Flow control bytes from uart_send_control go out ahead of
+ * console output.
+ */
+#define UART_RX_SIZE        16
+
+RING_EXTERN(uart_rx, uint8_t, UART_RX_SIZE, __xdata);
+
+// Task posted when a console byte arrives, SCHED_NO_TASK for none
+extern __data uint8_t uart_rx_task;
+
+// The number read_decimal_feed has built so far
+extern __xdata uint16_t read_decimal_value;
+
+/**
+ * @brief   Serial ISR for the console and the sample stream.
+ * @details The prototype must stay visible to main.c for the vector table.
+ */
+void uart_isr(void) __interrupt(4);
+
 int getchar (void);
 
 int putchar (int c);
@@ -8,5 +33,21 @@ int gety(void);
 
 void initialize_UART(void);
 
+/**
+ * @brief   Sends a flow control byte as soon as the transmitter is free.
+ * @details Call from the serial ISR or with the serial interrupt masked.
+ * @param   control: XON or XOFF.
+ * @return  void
+ */
+void uart_send_control(uint8_t control);
+
+/**
+ * @brief   Starts a new number for read_decimal_feed.
+ * @return  void
+ */
+void read_decimal_start(void);
+
+uint8_t read_decimal_feed(char c);
+
 
 #endif // _UART_H_
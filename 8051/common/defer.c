@@ -0,0 +1,78 @@
+// Author: Lokesh Senthil Kumar
+// defer.c file runs the deferred interrupt handlers from the main loop
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "sched.h"
+#include "defer.h"
+
+typedef struct {
+    char *name;
+    defer_fn_t fn;
+} defer_handler_t;
+
+__xdata defer_handler_t defer_handlers[DEFER_COUNT];
+
+volatile __data uint8_t defer_pending = 0;
+
+// Statistics; queued and dropped are written by the interrupt handlers
+__xdata uint16_t defer_queued[DEFER_COUNT];
+__xdata uint16_t defer_dropped[DEFER_COUNT];
+__xdata uint16_t defer_runs[DEFER_COUNT];
+
+void defer_register(uint8_t id, char *name, defer_fn_t fn)
+{
+    if (id < DEFER_COUNT) {
+        defer_handlers[id].name = name;
+        defer_handlers[id].fn = fn;
+    }
+}
+
+void defer_init(void)
+{
+    sched_add("defer", defer_run, 0);
+
+    // sched_add clears the post, bring back one raised before this
+    if (defer_pending) {
+        sched_post(DEFER_TASK);
+    }
+}
+
+void defer_run(void)
+{
+    uint8_t mask = 1;
+
+    for (uint8_t id = 0; id < DEFER_COUNT; id++, mask <<= 1) {
+        if (!(defer_pending & mask)) {
+            continue;
+        }
+        __critical {
+            defer_pending &= ~mask;     // a raise from now on is a new run
+        }
+        defer_runs[id]++;
+        if (defer_handlers[id].fn) {
+            defer_handlers[id].fn();
+        }
+    }
+}
+
+void defer_print_stats(void)
+{
+    uint16_t queued, dropped;
+
+    printf("\n\rDeferred   queued     run  dropped");
+    for (uint8_t id = 0; id < DEFER_COUNT; id++) {
+        __critical {
+            queued = defer_queued[id];
+            dropped = defer_dropped[id];
+            defer_queued[id] = 0;
+            defer_dropped[id] = 0;
+        }
+        printf("\n\r%-8s %8u %7u %8u",
+               defer_handlers[id].name ? defer_handlers[id].name : "-",
+               queued, defer_runs[id], dropped);
+        defer_runs[id] = 0;
+    }
+    printf("\n\r");
+}
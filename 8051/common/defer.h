@@ -0,0 +1,78 @@
+// Author: Lokesh Senthil Kumar
+// defer.h file declares the deferred handlers that finish interrupt work in the main loop
+
+#ifndef _DEFER_H_
+#define _DEFER_H_
+
+#include <stdint.h>
+#include "sched.h"
+
+/*
+ * Bottom halves. An interrupt handler does only what cannot wait, raises the
+ * pending bit of a deferred handler and returns. defer_run, the first
+ * scheduler task, then runs the pending handlers from the main loop in id
+ * order, so id 0 has the highest priority. A raise while the bit is still
+ * pending is merged into the run already owed and counted as dropped.
+ *
+ * Raising sets a bit with one ORL and bumps two counters, so it is cheap
+ * enough for a leaf handler that keeps its own register bank. Each id must
+ * be raised from one interrupt level only, or only from the foreground.
+ */
+
+/* ---- This program's deferred handlers, from its app_config.h ---- */
+
+#include "app_config.h"
+
+// defer_run must be added before any other task so it gets this id
+#define DEFER_TASK          0
+
+typedef void (*defer_fn_t)(void);
+
+// One bit per id, set by the raising handler, cleared before the run
+extern volatile __data uint8_t defer_pending;
+
+// Per id: raises that found the bit clear, and raises merged into a pending run
+extern __xdata uint16_t defer_queued[DEFER_COUNT];
+extern __xdata uint16_t defer_dropped[DEFER_COUNT];
+
+#define DEFER_RAISE(id) do {                            \
+        if (defer_pending & (1 << (id))) {              \
+            defer_dropped[(id)]++;                      \
+        } else {                                        \
+            defer_pending |= (1 << (id));               \
+            defer_queued[(id)]++;                       \
+            SCHED_POST_FROM_ISR(DEFER_TASK);            \
+        }                                               \
+    } while (0)
+
+/**
+ * @brief   Adds the defer_run task to the scheduler.
+ * @details Call before any other sched_add, after the handlers are set.
+ * @return  void
+ */
+void defer_init(void);
+
+/**
+ * @brief   Sets the handler run for an id.
+ * @param   id: The id, below DEFER_COUNT.
+ * @param   name: Short name for the statistics.
+ * @param   fn: The handler.
+ * @return  void
+ */
+void defer_register(uint8_t id, char *name, defer_fn_t fn);
+
+/**
+ * @brief   Runs every pending handler once, in priority order.
+ * @details Scheduler task; an id raised again while its handler runs is
+ *          picked up on the next pass.
+ * @return  void
+ */
+void defer_run(void);
+
+/**
+ * @brief   Prints queued, run and dropped counts per id and clears them.
+ * @return  void
+ */
+void defer_print_stats(void);
+
+#endif // _DEFER_H_
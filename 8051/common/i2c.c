@@ -0,0 +1,107 @@
+// Author: Lokesh Senthil Kumar
+// i2c.c file bit-bangs a standard mode I2C master on two port pins
+
+#include <stdint.h>
+#include <stdio.h>
+#include <at89c51ed2.h>
+
+#include "i2c.h"
+
+/*
+ * Half a bit. The call and return take 4 machine cycles and the loop 3 more,
+ * 7.6 us in all, so with the pin writes around it SCL is high past tHIGH and
+ * low past tLOW. A bit costs about 25 us, a byte with its ACK 0.23 ms.
+ * delay_us is not used here: its 32-bit setup alone outlasts a whole bit.
+ */
+#define I2C_DELAY_LOOPS     1
+
+__xdata uint16_t i2c_nacks = 0;
+
+static void i2c_delay(void)
+{
+    uint8_t n = I2C_DELAY_LOOPS;
+
+    while (--n) {
+    }
+}
+
+// One clock with SDA already set up, returns SDA sampled while SCL is high
+static uint8_t i2c_clock(void)
+{
+    uint8_t bit;
+
+    i2c_delay();                // tLOW
+    I2C_SCL_PIN = 1;
+    i2c_delay();                // tHIGH
+    bit = I2C_SDA_PIN;
+    I2C_SCL_PIN = 0;
+    return bit;
+}
+
+void i2c_start(void)
+{
+    I2C_SDA_PIN = 1;
+    i2c_delay();
+    I2C_SCL_PIN = 1;
+    i2c_delay();                // setup time of a repeated start
+    I2C_SDA_PIN = 0;
+    i2c_delay();                // hold time before the first clock
+    I2C_SCL_PIN = 0;
+}
+
+void i2c_stop(void)
+{
+    I2C_SDA_PIN = 0;
+    i2c_delay();
+    I2C_SCL_PIN = 1;
+    i2c_delay();                // setup time of the stop
+    I2C_SDA_PIN = 1;
+    i2c_delay();                // bus free time before the next start
+}
+
+uint8_t i2c_write(uint8_t value)
+{
+    for (uint8_t i = 0; i < 8; i++) {
+        I2C_SDA_PIN = (value & 0x80) ? 1 : 0;
+        i2c_clock();
+        value <<= 1;
+    }
+
+    I2C_SDA_PIN = 1;            // release SDA for the ACK
+    if (i2c_clock()) {
+        i2c_nacks++;
+        return I2C_NACK;
+    }
+    return I2C_ACK;
+}
+
+uint8_t i2c_read(uint8_t ack)
+{
+    uint8_t value = 0;
+
+    I2C_SDA_PIN = 1;            // the slave drives SDA
+    for (uint8_t i = 0; i < 8; i++) {
+        value = (value << 1) | i2c_clock();
+    }
+
+    I2C_SDA_PIN = (ack == I2C_ACK) ? 0 : 1;
+    i2c_clock();
+    I2C_SDA_PIN = 1;
+    return value;
+}
+
+void i2c_reset(void)
+{
+    I2C_SDA_PIN = 1;
+    for (uint8_t i = 0; i < 9; i++) {
+        i2c_clock();
+    }
+    i2c_start();
+    i2c_stop();
+}
+
+void i2c_print_stats(void)
+{
+    printf("\n\rI2C NACKs        : %u\n\r", i2c_nacks);
+    i2c_nacks = 0;
+}
@@ -0,0 +1,73 @@
+// Author: Lokesh Senthil Kumar
+// i2c.h file declares the bit-banged I2C master shared by the 8051 programs
+
+#ifndef _I2C_H_
+#define _I2C_H_
+
+#include <stdint.h>
+#include <at89c51ed2.h>
+
+/*
+ * Standard mode timing: SCL stays high at least 4 us (tHIGH) and low at least
+ * 4.7 us (tLOW), and SDA only changes while SCL is low. The port 1 pins are
+ * quasi-bidirectional, so writing 1 releases a line for the slave to pull.
+ *
+ * A program picks its pins by defining I2C_SDA_PIN and I2C_SCL_PIN from its
+ * Makefile; the defaults are the IO expander board wiring.
+ */
+#ifndef I2C_SDA_PIN
+#define I2C_SDA_PIN         P1_5
+#endif
+#ifndef I2C_SCL_PIN
+#define I2C_SCL_PIN         P1_4
+#endif
+
+#define I2C_READ            0x01    // R/W bit of the address byte
+
+#define I2C_ACK             0
+#define I2C_NACK            1
+
+// Bytes the slave did not acknowledge
+extern __xdata uint16_t i2c_nacks;
+
+/**
+ * @brief   Sends a start, or a repeated start inside a transaction.
+ * @return  void
+ */
+void i2c_start(void);
+
+/**
+ * @brief   Sends a stop and leaves both lines released.
+ * @return  void
+ */
+void i2c_stop(void);
+
+/**
+ * @brief   Sends a byte and reads the acknowledge bit.
+ * @details A NACK is counted in i2c_nacks.
+ * @param   value: The byte, MSB first.
+ * @return  I2C_ACK or I2C_NACK.
+ */
+uint8_t i2c_write(uint8_t value);
+
+/**
+ * @brief   Reads a byte and answers it.
+ * @param   ack: I2C_ACK to ask for another byte, I2C_NACK after the last.
+ * @return  The byte.
+ */
+uint8_t i2c_read(uint8_t ack);
+
+/**
+ * @brief   Frees a slave stuck in the middle of a byte.
+ * @details Clocks nine bits with SDA released, then a start and a stop.
+ * @return  void
+ */
+void i2c_reset(void);
+
+/**
+ * @brief   Prints the NACK count to the UART console and clears it.
+ * @return  void
+ */
+void i2c_print_stats(void);
+
+#endif // _I2C_H_
@@ -0,0 +1,75 @@
+// Author: Lokesh Senthil Kumar
+// irq.c file programs the interrupt priorities and reports entry latencies
+
+#include <stdint.h>
+#include <stdio.h>
+#include <at89c51ed2.h>
+
+#include "irq.h"
+
+typedef struct {
+    char *name;
+    uint8_t vector;
+    uint8_t level;
+    uint16_t budget_us;
+    uint16_t cost_us;
+    uint8_t measured;       // 0 if the hardware gives no entry timestamp
+} irq_source_t;
+
+#define IRQ_ROW(src, unused) \
+    { #src, IRQ_##src##_VECTOR, IRQ_LEVEL(src), IRQ_##src##_BUDGET_US, \
+      IRQ_##src##_COST_US, IRQ_##src##_MEASURED },
+
+__code irq_source_t irq_sources[] = { IRQ_LIST(IRQ_ROW, 0) };
+#define IRQ_SOURCE_COUNT    (sizeof(irq_sources) / sizeof(irq_sources[0]))
+
+#ifdef IRQ_MEASURE
+volatile __xdata uint16_t irq_latency_max[IRQ_VECTORS];
+#endif
+
+void irq_init(void)
+{
+    IPH0 = IRQ_IPH0_VALUE;
+    IPL0 = IRQ_IPL0_VALUE;
+}
+
+// The bound the build checked: critical sections plus every other source
+// at the same level or above, once each
+static uint16_t irq_worst_us(__code irq_source_t *src)
+{
+    uint16_t worst = IRQ_CRITICAL_US;
+
+    for (uint8_t i = 0; i < IRQ_SOURCE_COUNT; i++) {
+        if (&irq_sources[i] != src && irq_sources[i].level >= src->level) {
+            worst += irq_sources[i].cost_us;
+        }
+    }
+    return worst;
+}
+
+void irq_print_stats(void)
+{
+    __code irq_source_t *src;
+#ifdef IRQ_MEASURE
+    uint16_t cycles;
+#endif
+
+    printf("\n\rIRQ     lvl budget us  cost us  worst us  seen us");
+    for (uint8_t i = 0; i < IRQ_SOURCE_COUNT; i++) {
+        src = &irq_sources[i];
+        printf("\n\r%-7s %3u %9u %8u %9u", src->name, (uint16_t)src->level,
+               src->budget_us, src->cost_us, irq_worst_us(src));
+#ifdef IRQ_MEASURE
+        if (src->measured) {
+            __critical {
+                cycles = irq_latency_max[src->vector];
+                irq_latency_max[src->vector] = 0;
+            }
+            printf(" %8lu", ((uint32_t)cycles * 217) / 200);
+            continue;
+        }
+#endif
+        printf("        -");
+    }
+    printf("\n\r");
+}
@@ -0,0 +1,130 @@
+// Author: Lokesh Senthil Kumar
+// irq.h file assigns the interrupt priorities from each source's latency budget
+
+#ifndef _IRQ_H_
+#define _IRQ_H_
+
+#include <stdint.h>
+
+/*
+ * Every interrupt a program enables is listed in its app_config.h, named
+ * as in the vector table below (IRQ_LIST), with two numbers:
+ * COST, the longest its handler runs, and BUDGET, the longest it may wait
+ * from its flag being set to its handler starting. The priority level (0
+ * lowest, 3 highest) follows from the budget alone, so a tighter budget
+ * always preempts a looser one. irq_init writes IPL0 and IPH0 in one go;
+ * nothing else in the program touches the priority bits.
+ *
+ * A source can be held off by interrupts-off sections (IRQ_CRITICAL_US) and
+ * by handlers at its own level or above. If each of those fires once, the
+ * sum has to fit in the budget, otherwise the build stops with #error.
+ *
+ * The COST figures are estimates counted from the handler source, not
+ * measurements, so the check is only as good as they are. Build with
+ * make IRQ_MEASURE=1, run the program under its heaviest load, and copy the
+ * worst times from the IRQ stats into the COST lines of app_config.h before
+ * trusting it.
+ *
+ * A handler that calls no functions can take __using(IRQ_BANK(src)) and skip
+ * saving R0-R7. Handlers on one level never interrupt each other, so they
+ * share that level's bank; main keeps bank 0, so a level 0 source must not
+ * switch banks. Handlers that call functions stay on bank 0, because the
+ * callees address R0-R7 of bank 0 directly.
+ */
+
+/* Vector numbers, also the bit of each source in IEN0, IPL0 and IPH0 */
+#define IRQ_EXT0_VECTOR     0
+#define IRQ_TIMER0_VECTOR   1
+#define IRQ_EXT1_VECTOR     2
+#define IRQ_TIMER1_VECTOR   3
+#define IRQ_SERIAL_VECTOR   4
+#define IRQ_TIMER2_VECTOR   5
+#define IRQ_PCA_VECTOR      6
+#define IRQ_VECTORS         7
+
+/* Priority level for a latency budget in us */
+#define IRQ_LEVEL_FOR(budget_us) \
+    ((budget_us) <= 100 ? 3 : (budget_us) <= 300 ? 2 : (budget_us) <= 1000 ? 1 : 0)
+
+/* ---- This program's sources, with their estimated costs ---- */
+
+#include "app_config.h"
+
+/* ---- Derived values and build-time checks ---- */
+
+#define IRQ_LEVEL(src)      IRQ_LEVEL_FOR(IRQ_##src##_BUDGET_US)
+#define IRQ_BANK(src)       IRQ_LEVEL(src)
+
+// Cost of src if it can hold off a handler at level lvl
+#define IRQ_HOLD_TERM(src, lvl) + (IRQ_LEVEL(src) >= (lvl) ? IRQ_##src##_COST_US : 0)
+#define IRQ_WORST_US(src) \
+    (IRQ_CRITICAL_US IRQ_LIST(IRQ_HOLD_TERM, IRQ_LEVEL(src)) - IRQ_##src##_COST_US)
+
+#define IRQ_IPL_TERM(src, unused) | ((IRQ_LEVEL(src) & 1) << IRQ_##src##_VECTOR)
+#define IRQ_IPH_TERM(src, unused) | ((IRQ_LEVEL(src) >> 1) << IRQ_##src##_VECTOR)
+#define IRQ_IPL0_VALUE      (0 IRQ_LIST(IRQ_IPL_TERM, 0))
+#define IRQ_IPH0_VALUE      (0 IRQ_LIST(IRQ_IPH_TERM, 0))
+
+// Checked for each source the program lists
+#if defined(IRQ_EXT0_BUDGET_US) && IRQ_WORST_US(EXT0) > IRQ_EXT0_BUDGET_US
+#error "External 0 can wait longer than its latency budget"
+#endif
+#if defined(IRQ_TIMER0_BUDGET_US) && IRQ_WORST_US(TIMER0) > IRQ_TIMER0_BUDGET_US
+#error "Timer 0 can wait longer than its latency budget"
+#endif
+#if defined(IRQ_EXT1_BUDGET_US) && IRQ_WORST_US(EXT1) > IRQ_EXT1_BUDGET_US
+#error "External 1 can wait longer than its latency budget"
+#endif
+#if defined(IRQ_TIMER1_BUDGET_US) && IRQ_WORST_US(TIMER1) > IRQ_TIMER1_BUDGET_US
+#error "Timer 1 can wait longer than its latency budget"
+#endif
+#if defined(IRQ_SERIAL_BUDGET_US) && IRQ_WORST_US(SERIAL) > IRQ_SERIAL_BUDGET_US
+#error "Serial can wait longer than its latency budget"
+#endif
+#if defined(IRQ_TIMER2_BUDGET_US) && IRQ_WORST_US(TIMER2) > IRQ_TIMER2_BUDGET_US
+#error "Timer 2 can wait longer than its latency budget"
+#endif
+#if defined(IRQ_PCA_BUDGET_US) && IRQ_WORST_US(PCA) > IRQ_PCA_BUDGET_US
+#error "PCA can wait longer than its latency budget"
+#endif
+
+/* ---- Measurement mode (make IRQ_MEASURE=1) ---- */
+
+#ifdef IRQ_MEASURE
+// Worst entry latency per vector in machine cycles, written by the handlers
+extern volatile __xdata uint16_t irq_latency_max[IRQ_VECTORS];
+
+#define IRQ_NOTE_LATENCY(vector, cycles) do {                   \
+        uint16_t irq_c_ = (cycles);                             \
+        if (irq_c_ > irq_latency_max[vector]) {                 \
+            irq_latency_max[vector] = irq_c_;                   \
+        }                                                       \
+    } while (0)
+#else
+#define IRQ_NOTE_LATENCY(vector, cycles)
+#endif
+
+/* Timer 0 in mode 1 counts up from 0 after overflowing; use before the reload */
+#define IRQ_MEASURE_TIMER0() \
+    IRQ_NOTE_LATENCY(IRQ_TIMER0_VECTOR, TL0 | ((uint16_t)TH0 << 8))
+
+/* Timer 2 restarts from RCAP2 when it overflows */
+#define IRQ_MEASURE_TIMER2() \
+    IRQ_NOTE_LATENCY(IRQ_TIMER2_VECTOR, (TL2 | ((uint16_t)TH2 << 8)) - \
+                     (RCAP2L | ((uint16_t)RCAP2H << 8)))
+
+/**
+ * @brief   Sets the priority level of every source from its budget.
+ * @details Call once at the start of main, before any interrupt is enabled.
+ * @return  void
+ */
+void irq_init(void);
+
+/**
+ * @brief   Prints level, budget and cost per source, and in measurement
+ *          builds the worst entry latency seen since the last call.
+ * @return  void
+ */
+void irq_print_stats(void);
+
+#endif // _IRQ_H_
@@ -0,0 +1,77 @@
+// Author: Lokesh Senthil Kumar
+// ring.h file generates single-producer single-consumer ring buffers
+
+#ifndef _RING_H_
+#define _RING_H_
+
+#include <stdint.h>
+
+/*
+ * A ring is an array of any element type plus two 8-bit indices in internal
+ * RAM. Only the producer writes head and only the consumer writes tail, and
+ * an 8-bit store cannot be split by an interrupt, so an ISR and the
+ * foreground (or two ISRs) can share a ring with no critical section. The
+ * producer fills the slot before it moves head; the consumer reads the slot
+ * before it moves tail.
+ *
+ * The size must be a power of two up to 256; one slot stays empty to tell a
+ * full ring from an empty one. The buffer goes in __xdata or __idata.
+ *
+ *     RING_DEFINE(rx, uint8_t, 64, __xdata);   // in one .c file
+ *
+ *     if (!RING_FULL(rx)) RING_PUT(rx, SBUF);   // producer
+ *     if (!RING_EMPTY(rx)) RING_GET(rx, c);     // consumer
+ *
+ * Struct elements are filled in place with RING_NEW and RING_COMMIT, and read
+ * in place with RING_PEEK and RING_DROP.
+ */
+
+#define RING_DEFINE(name, type, size, space)                                \
+    typedef char name##_size_check[((size) & ((size) - 1)) == 0 &&          \
+                                   (size) <= 256 ? 1 : -1];                 \
+    space type name##_buf[(size)];                                          \
+    volatile __data uint8_t name##_head = 0;                                \
+    volatile __data uint8_t name##_tail = 0
+
+// For the other files that use a ring defined elsewhere
+#define RING_EXTERN(name, type, size, space)                                \
+    extern space type name##_buf[(size)];                                   \
+    extern volatile __data uint8_t name##_head;                             \
+    extern volatile __data uint8_t name##_tail
+
+#define RING_MASK(name)     ((uint8_t)(sizeof(name##_buf) / sizeof(name##_buf[0]) - 1))
+#define RING_NEXT(name, i)  ((uint8_t)((i) + 1) & RING_MASK(name))
+
+/* Either side */
+#define RING_COUNT(name)    ((uint8_t)(name##_head - name##_tail) & RING_MASK(name))
+#define RING_EMPTY(name)    (name##_head == name##_tail)
+#define RING_FULL(name)     (RING_NEXT(name, name##_head) == name##_tail)
+
+/* Producer, only when not RING_FULL */
+#define RING_NEW(name)      (name##_buf[name##_head])
+#define RING_COMMIT(name)   (name##_head = RING_NEXT(name, name##_head))
+#define RING_PUT(name, value) do {                                          \
+        RING_NEW(name) = (value);                                           \
+        RING_COMMIT(name);                                                  \
+    } while (0)
+
+/* Consumer, only when not RING_EMPTY */
+#define RING_PEEK(name)     (name##_buf[name##_tail])
+#define RING_DROP(name)     (name##_tail = RING_NEXT(name, name##_tail))
+#define RING_GET(name, var) do {                                            \
+        (var) = RING_PEEK(name);                                            \
+        RING_DROP(name);                                                    \
+    } while (0)
+
+// Empties the ring; only while neither side can run
+#define RING_RESET(name)    do { name##_head = 0; name##_tail = 0; } while (0)
+
+// Optional high-water mark, peak is a uint8_t the caller owns
+#define RING_HIGH_WATER(name, peak) do {                                    \
+        uint8_t ring_fill_ = RING_COUNT(name);                              \
+        if (ring_fill_ > (peak)) {                                          \
+            (peak) = ring_fill_;                                            \
+        }                                                                   \
+    } while (0)
+
+#endif // _RING_H_
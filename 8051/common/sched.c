@@ -0,0 +1,127 @@
+// Author: Lokesh Senthil Kumar
+// sched.c file runs periodic and event tasks and accounts their run time
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "timebase.h"
+#include "sched.h"
+
+typedef struct {
+    char *name;
+    sched_fn_t fn;
+    uint16_t period_ms;     // 0 for event-only tasks
+    uint32_t next_run;      // millis() deadline of the next periodic run
+    uint16_t runs;          // runs in the measurement window
+    uint32_t counts;        // Timer 2 counts spent in the window
+    uint32_t max_counts;    // longest single run, not clamped so a blocking task shows
+} sched_task_t;
+
+__xdata sched_task_t sched_tasks[SCHED_MAX_TASKS];
+uint8_t sched_count = 0;
+
+// Posted events, one byte per task so a post is a single store
+volatile __xdata uint8_t sched_pending[SCHED_MAX_TASKS];
+
+// Start of the measurement window, Timer 2 counts
+__xdata uint32_t sched_window_start = 0;
+
+uint8_t sched_add(char *name, sched_fn_t fn, uint16_t period_ms)
+{
+    __xdata sched_task_t *task;
+
+    if (sched_count >= SCHED_MAX_TASKS) {
+        return SCHED_NO_TASK;
+    }
+    task = &sched_tasks[sched_count];
+    task->name = name;
+    task->fn = fn;
+    task->period_ms = period_ms;
+    task->next_run = timebase_deadline(period_ms);
+    task->runs = 0;
+    task->counts = 0;
+    task->max_counts = 0;
+    sched_pending[sched_count] = 0;
+    return sched_count++;
+}
+
+void sched_post(uint8_t id)
+{
+    if (id < SCHED_MAX_TASKS) {
+        sched_pending[id] = 1;
+    }
+}
+
+static void sched_dispatch(__xdata sched_task_t *task)
+{
+    uint32_t start = timebase_stamp();
+    uint32_t spent;
+
+    task->fn();
+
+    spent = timebase_stamp() - start;
+    task->runs++;
+    task->counts += spent;
+    if (spent > task->max_counts) {
+        task->max_counts = spent;
+    }
+}
+
+void sched_run(void)
+{
+    __xdata sched_task_t *task;
+
+    sched_window_start = timebase_stamp();
+    while (1) {
+        for (uint8_t i = 0; i < sched_count; i++) {
+            task = &sched_tasks[i];
+            if (sched_pending[i]) {
+                sched_pending[i] = 0;
+                sched_dispatch(task);
+            } else if (task->period_ms && timebase_expired(task->next_run)) {
+                task->next_run += task->period_ms;
+                if (timebase_expired(task->next_run)) {
+                    task->next_run = timebase_deadline(task->period_ms);  // overran, drop the missed runs
+                }
+                sched_dispatch(task);
+            }
+        }
+    }
+}
+
+// Timer 2 counts to us (x 1.085), split so long runs do not overflow
+static uint32_t sched_counts_to_us(uint32_t counts)
+{
+    return (counts / 200) * 217 + ((counts % 200) * 217) / 200;
+}
+
+void sched_print_stats(void)
+{
+    __xdata sched_task_t *task;
+    uint32_t window = timebase_stamp() - sched_window_start;
+    uint32_t per_mille = window / 1000;     // counts in 0.1 % of the window
+    uint32_t busy = 0;
+    uint16_t share;
+
+    if (per_mille == 0) {
+        per_mille = 1;
+    }
+
+    printf("\n\rTask      runs   time ms    max us  cpu %%");
+    for (uint8_t i = 0; i < sched_count; i++) {
+        task = &sched_tasks[i];
+        busy += task->counts;
+        share = task->counts / per_mille;
+        printf("\n\r%-8s %5u %9lu %9lu %3u.%u",
+               task->name, task->runs, task->counts / TIMEBASE_COUNTS_PER_MS,
+               sched_counts_to_us(task->max_counts),
+               share / 10, share % 10);
+        task->runs = 0;
+        task->counts = 0;
+        task->max_counts = 0;
+    }
+    share = busy / per_mille;
+    printf("\n\rWindow %lu ms, idle %u.%u %%\n\r", window / TIMEBASE_COUNTS_PER_MS,
+           (1000 - share) / 10, (1000 - share) % 10);
+    sched_window_start = timebase_stamp();
+}
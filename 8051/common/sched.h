@@ -0,0 +1,58 @@
+// Author: Lokesh Senthil Kumar
+// sched.h file declares the cooperative task scheduler
+
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#include <stdint.h>
+
+/*
+ * Tasks run to completion in the main loop, in the order they were added.
+ * A task runs when its period (on the 1 ms timebase) has passed or when an
+ * event was posted for it; sched_post only writes one byte, so interrupts
+ * may call it. Run time is measured in Timer 2 counts (1.085 us) per task.
+ */
+#define SCHED_MAX_TASKS     8
+#define SCHED_NO_TASK       0xFF
+
+typedef void (*sched_fn_t)(void);
+
+/**
+ * @brief   Adds a task.
+ * @param   name: Short name for the statistics.
+ * @param   fn: The task body.
+ * @param   period_ms: Run every period_ms, or 0 to run only on events.
+ * @return  The task id for sched_post, or SCHED_NO_TASK if the table is full.
+ */
+uint8_t sched_add(char *name, sched_fn_t fn, uint16_t period_ms);
+
+/**
+ * @brief   Asks for a task to run on the next pass. Safe from interrupts.
+ * @param   id: The task id.
+ * @return  void
+ */
+void sched_post(uint8_t id);
+
+// Posted events, one byte per task
+extern volatile __xdata uint8_t sched_pending[SCHED_MAX_TASKS];
+
+/*
+ * sched_post without the call, for a handler that should stay a leaf and
+ * keep its own register bank. id must be a valid task id.
+ */
+#define SCHED_POST_FROM_ISR(id)     (sched_pending[(id)] = 1)
+
+/**
+ * @brief   Runs the tasks forever.
+ * @return  Never.
+ */
+void sched_run(void);
+
+/**
+ * @brief   Prints runs, run time and CPU share per task, then restarts the
+ *          measurement window.
+ * @return  void
+ */
+void sched_print_stats(void);
+
+#endif // _SCHED_H_
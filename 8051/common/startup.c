@@ -0,0 +1,58 @@
+// Author: Lokesh Senthil Kumar
+// startup.c file times the C startup with Timer 2
+
+#include <stdint.h>
+#include <stdio.h>
+#include <at89c51ed2.h>
+
+#include "startup.h"
+
+// Result of startup_time_us, for figures that count from reset
+__xdata uint32_t startup_us = 0;
+
+// Set when Timer 2 wrapped, startup_us is then only a lower bound
+__xdata uint8_t startup_overflow = 0;
+
+unsigned char _sdcc_external_startup(void)
+{
+    // Nothing else runs yet; Timer 2 counts machine cycles up to main
+    T2CON = 0x00;
+    RCAP2H = 0x00;
+    RCAP2L = 0x00;
+    TH2 = 0x00;
+    TL2 = 0x00;
+    TR2 = 1;
+    return 0;
+}
+
+// SDCC 4.2 and later call the hook by this name
+unsigned char __sdcc_external_startup(void)
+{
+    return _sdcc_external_startup();
+}
+
+uint32_t startup_time_us(void)
+{
+    uint16_t counts;
+
+    TR2 = 0;
+    counts = ((uint16_t)TH2 << 8) | TL2;
+
+    // TF2 only says the counter wrapped at least once, so a longer boot is
+    // reported as the most the 16 bits can hold
+    if (TF2) {
+        TF2 = 0;
+        startup_overflow = 1;
+        startup_us = STARTUP_US_MAX;
+        return startup_us;
+    }
+
+    // One count per machine cycle, 1.0851 us at 11.0592 MHz (217/200)
+    startup_us = ((uint32_t)counts * 217) / 200;
+    return startup_us;
+}
+
+void startup_print(void)
+{
+    printf(startup_overflow ? "over %lu us" : "%lu us", startup_us);
+}
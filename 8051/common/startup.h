@@ -0,0 +1,59 @@
+// Author: Lokesh Senthil Kumar
+// startup.h file declares the C startup hook and the persistent NVRAM region
+
+#ifndef _STARTUP_H_
+#define _STARTUP_H_
+
+#include <stdint.h>
+
+/*
+ * The Makefile stops --xram-size at PERSIST_ADDR, so the linker never places
+ * variables in the top 256 bytes of the battery-backed NVRAM and the C startup
+ * code never clears or initializes them. Declare warm-restart state there
+ * with __xdata __at(...) and no initializer, and validate it before use.
+ */
+#define PERSIST_ADDR    0x7F00
+#define PERSIST_SIZE    0x0100
+
+/*
+ * Tables the C startup used to copy into XRAM live in code. Building with
+ * STARTUP_BASELINE=1 puts them back in XRAM, so the board prints the boot
+ * time from before that change with the same Timer 2 method.
+ */
+#ifdef STARTUP_BASELINE
+#define STARTUP_TABLE   __xdata
+#else
+#define STARTUP_TABLE   __code
+#endif
+
+// Most Timer 2 can time, 65536 machine cycles
+#define STARTUP_US_MAX  71106UL
+
+/**
+ * @brief   Runs before the C startup clears and initializes XRAM.
+ * @details Starts Timer 2 free-running so main can measure how long the C
+ *          startup took. Returns 0 so the normal initialization still runs.
+ * @return  0
+ */
+unsigned char _sdcc_external_startup(void);
+
+/**
+ * @brief   Stops the Timer 2 started by _sdcc_external_startup.
+ * @details Call first thing in main, before anything else uses Timer 2. The
+ *          result is also kept in startup_us. A boot longer than Timer 2 can
+ *          count sets startup_overflow and gives STARTUP_US_MAX.
+ * @return  Microseconds from reset to main.
+ */
+uint32_t startup_time_us(void);
+
+/**
+ * @brief   Prints startup_us, marked as a lower bound if Timer 2 overflowed.
+ * @return  void
+ */
+void startup_print(void);
+
+// Microseconds from reset to main, valid once startup_time_us has run
+extern __xdata uint32_t startup_us;
+extern __xdata uint8_t startup_overflow;
+
+#endif // _STARTUP_H_
@@ -0,0 +1,141 @@
+// Author: Lokesh Senthil Kumar
+// swtimer.c file runs one-shot and periodic software timers on a hashed wheel
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "timebase.h"
+#include "swtimer.h"
+
+// One list per slot, plus one for the timers being fired this tick
+__xdata swtimer_t * __xdata swtimer_heads[SWTIMER_SLOTS + 1];
+#define SWTIMER_FIRING  SWTIMER_SLOTS
+
+// Last tick the wheel has processed, in millis()
+__xdata uint32_t swtimer_tick = 0;
+
+// Statistics
+__xdata uint32_t swtimer_fired = 0;
+__xdata uint16_t swtimer_late_max = 0;     // ms between due and run
+
+static void swtimer_push(__xdata swtimer_t *t, uint8_t slot)
+{
+    t->armed = 1;
+    t->slot = slot;
+    t->prev = NULL;
+    t->next = swtimer_heads[slot];
+    if (t->next) {
+        t->next->prev = t;
+    }
+    swtimer_heads[slot] = t;
+}
+
+static void swtimer_unlink(__xdata swtimer_t *t)
+{
+    if (t->prev) {
+        t->prev->next = t->next;
+    } else {
+        swtimer_heads[t->slot] = t->next;
+    }
+    if (t->next) {
+        t->next->prev = t->prev;
+    }
+    t->armed = 0;
+}
+
+// Put a timer in the slot that comes round in ticks ms after swtimer_tick
+static void swtimer_link(__xdata swtimer_t *t, uint32_t ticks)
+{
+    t->rounds = (uint16_t)((ticks - 1) >> SWTIMER_SLOT_BITS);
+    swtimer_push(t, (uint8_t)(swtimer_tick + ticks) & SWTIMER_SLOT_MASK);
+}
+
+void swtimer_init(void)
+{
+    for (uint8_t i = 0; i <= SWTIMER_SLOTS; i++) {
+        swtimer_heads[i] = NULL;
+    }
+    swtimer_tick = millis();
+    swtimer_fired = 0;
+    swtimer_late_max = 0;
+}
+
+void swtimer_start(__xdata swtimer_t *t, uint16_t delay_ms, uint16_t period_ms,
+                   swtimer_fn_t fn, uint8_t arg)
+{
+    if (t->armed) {
+        swtimer_unlink(t);
+    }
+    if (delay_ms == 0) {
+        delay_ms = 1;
+    }
+    t->fn = fn;
+    t->arg = arg;
+    t->period_ms = period_ms;
+    // The wheel may be a few ticks behind millis(), count from real time
+    swtimer_link(t, delay_ms + (millis() - swtimer_tick));
+}
+
+void swtimer_stop(__xdata swtimer_t *t)
+{
+    if (t->armed) {
+        swtimer_unlink(t);
+    }
+}
+
+uint8_t swtimer_active(__xdata swtimer_t *t)
+{
+    return t->armed;
+}
+
+void swtimer_poll(void)
+{
+    uint32_t now = millis();
+    __xdata swtimer_t *t;
+    __xdata swtimer_t *next;
+    uint16_t late;
+
+    while (swtimer_tick != now) {
+        swtimer_tick++;
+
+        // Move what is due to the firing list, the rest waits another turn
+        for (t = swtimer_heads[(uint8_t)swtimer_tick & SWTIMER_SLOT_MASK]; t; t = next) {
+            next = t->next;
+            if (t->rounds) {
+                t->rounds--;
+            } else {
+                swtimer_unlink(t);
+                swtimer_push(t, SWTIMER_FIRING);
+            }
+        }
+
+        // A callback may stop a timer still on this list, so take one at a time
+        while ((t = swtimer_heads[SWTIMER_FIRING]) != NULL) {
+            swtimer_unlink(t);
+            if (t->period_ms) {
+                swtimer_link(t, t->period_ms);  // from the due tick, no drift
+            }
+            late = (uint16_t)(now - swtimer_tick);
+            if (late > swtimer_late_max) {
+                swtimer_late_max = late;
+            }
+            swtimer_fired++;
+            t->fn(t->arg);
+        }
+    }
+}
+
+void swtimer_print_stats(void)
+{
+    __xdata swtimer_t *t;
+    uint16_t armed = 0;
+
+    for (uint8_t i = 0; i < SWTIMER_SLOTS; i++) {
+        for (t = swtimer_heads[i]; t; t = t->next) {
+            armed++;
+        }
+    }
+    printf("\n\rTimers: %u armed, %lu fired, worst %u ms late\n\r",
+           armed, swtimer_fired, swtimer_late_max);
+}
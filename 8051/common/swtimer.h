@@ -0,0 +1,80 @@
+// Author: Lokesh Senthil Kumar
+// swtimer.h file declares the software timers that share the 1 ms timebase
+
+#ifndef _SWTIMER_H_
+#define _SWTIMER_H_
+
+#include <stdint.h>
+
+/*
+ * Hashed timer wheel on the 1 ms timebase. A timer due in d ms sits in slot
+ * (now + d) % SWTIMER_SLOTS with (d - 1) / SWTIMER_SLOTS full turns to wait,
+ * so start and stop are O(1) and each tick only looks at one slot. Timers
+ * belong to their owners; any number can be armed. Callbacks run from
+ * swtimer_poll in the foreground, never from an interrupt, and may start or
+ * stop any timer including their own. A timer must start out zeroed, as
+ * globals are.
+ */
+#define SWTIMER_SLOT_BITS   6
+#define SWTIMER_SLOTS       (1 << SWTIMER_SLOT_BITS)
+#define SWTIMER_SLOT_MASK   (SWTIMER_SLOTS - 1)
+
+typedef void (*swtimer_fn_t)(uint8_t arg);
+
+typedef struct swtimer {
+    __xdata struct swtimer *next;
+    __xdata struct swtimer *prev;
+    swtimer_fn_t fn;
+    uint16_t period_ms;     // 0 for a one-shot
+    uint16_t rounds;        // wheel turns left before it is due
+    uint8_t slot;           // list it is on, valid while armed
+    uint8_t armed;
+    uint8_t arg;            // passed to fn
+} swtimer_t;
+
+/**
+ * @brief   Empties the wheel and starts it at the current millis().
+ * @return  void
+ */
+void swtimer_init(void);
+
+/**
+ * @brief   Arms a timer, moving it if it was already armed.
+ * @param   t: The timer.
+ * @param   delay_ms: Time to the first expiry, 0 is taken as 1.
+ * @param   period_ms: Time between later expiries, 0 for a one-shot.
+ * @param   fn: Called on expiry with arg.
+ * @param   arg: Passed to fn.
+ * @return  void
+ */
+void swtimer_start(__xdata swtimer_t *t, uint16_t delay_ms, uint16_t period_ms,
+                   swtimer_fn_t fn, uint8_t arg);
+
+/**
+ * @brief   Disarms a timer. Stopping an idle timer does nothing.
+ * @param   t: The timer.
+ * @return  void
+ */
+void swtimer_stop(__xdata swtimer_t *t);
+
+/**
+ * @brief   Tells if a timer is armed.
+ * @param   t: The timer.
+ * @return  1 if armed, 0 if idle.
+ */
+uint8_t swtimer_active(__xdata swtimer_t *t);
+
+/**
+ * @brief   Advances the wheel to millis() and runs the callbacks that fell
+ *          due. Call it from a 1 ms task.
+ * @return  void
+ */
+void swtimer_poll(void);
+
+/**
+ * @brief   Prints the armed and fired counts and the worst lateness.
+ * @return  void
+ */
+void swtimer_print_stats(void);
+
+#endif // _SWTIMER_H_
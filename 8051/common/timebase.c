@@ -0,0 +1,128 @@
+// Author: Lokesh Senthil Kumar
+// timebase.c file keeps a millisecond tick on Timer 2 and provides delays
+
+#include <stdint.h>
+#include <at89c51ed2.h>
+
+#include "app_config.h"
+#include "timebase.h"
+#include "irq.h"
+
+// A program can add work to the tick in its app_config.h, see timebase.h
+#ifdef TIMEBASE_TICK_INCLUDE
+#include TIMEBASE_TICK_INCLUDE
+#endif
+#ifndef TIMEBASE_TICK
+#define TIMEBASE_TICK()
+#endif
+
+// Milliseconds since timebase_init, only written by the ISR
+volatile __data uint32_t timebase_ms = 0;
+
+static uint16_t timebase_counts(void);
+
+void timebase_ISR(void) __interrupt(5) __using(IRQ_BANK(TIMER2))
+{
+    IRQ_MEASURE_TIMER2();
+    TF2 = 0;
+    timebase_ms++;
+    TIMEBASE_TICK();
+}
+
+void timebase_init(void)
+{
+    T2CON = 0x00;               // 16-bit auto-reload, internal clock
+    RCAP2H = TIMEBASE_RELOAD_H;
+    RCAP2L = TIMEBASE_RELOAD_L;
+    TH2 = TIMEBASE_RELOAD_H;
+    TL2 = TIMEBASE_RELOAD_L;
+    ET2 = 1;
+    EA = 1;
+    TR2 = 1;
+}
+
+uint32_t timebase_stamp(void)
+{
+    uint32_t ms;
+    uint16_t counts;
+    uint8_t et2 = ET2;
+
+    ET2 = 0;
+    ms = timebase_ms;
+    counts = timebase_counts();
+    if (TF2) {
+        ms++;                   // reloaded after the mask, tick not yet counted
+        counts = timebase_counts();
+    }
+    ET2 = et2;
+    return ms * TIMEBASE_COUNTS_PER_MS + counts;
+}
+
+uint32_t millis(void)
+{
+    uint32_t now;
+    uint8_t et2 = ET2;
+
+    ET2 = 0;                    // four bytes, read them in one piece
+    now = timebase_ms;
+    ET2 = et2;
+    return now;
+}
+
+// Position inside the current millisecond, 0 to TIMEBASE_COUNTS_PER_MS - 1
+static uint16_t timebase_counts(void)
+{
+    uint8_t high, low;
+
+    do {
+        high = TH2;
+        low = TL2;
+    } while (high != TH2);      // TL2 rolled into TH2 between the reads
+
+    return (((uint16_t)high << 8) | low) - TIMEBASE_RELOAD;
+}
+
+void delay_us(uint16_t us)
+{
+    // 0.9216 counts per us, as 59/64 so the product stays in 32 bits
+    uint32_t target = ((uint32_t)us * 59) >> 6;
+    uint32_t elapsed = 0;
+    uint16_t last = timebase_counts();
+    uint16_t now;
+
+    while (elapsed < target) {
+        now = timebase_counts();
+        if (now >= last) {
+            elapsed += now - last;
+        } else {
+            elapsed += now + TIMEBASE_COUNTS_PER_MS - last;     // reloaded
+        }
+        last = now;
+    }
+}
+
+void delay_ms(uint16_t ms)
+{
+    uint32_t deadline;
+
+    if (!EA || !ET2) {
+        while (ms--) {
+            delay_us(1000);     // tick cannot run, count the timer directly
+        }
+        return;
+    }
+
+    deadline = timebase_deadline(ms);
+    while (!timebase_expired(deadline)) {
+    }
+}
+
+uint32_t timebase_deadline(uint16_t ms)
+{
+    return millis() + ms + 1;   // +1 so a partial first tick is not counted
+}
+
+uint8_t timebase_expired(uint32_t deadline)
+{
+    return (int32_t)(millis() - deadline) >= 0;
+}
@@ -0,0 +1,83 @@
+// Author: Lokesh Senthil Kumar
+// timebase.h file declares the Timer 2 millisecond tick, delays and deadlines
+
+#ifndef _TIMEBASE_H_
+#define _TIMEBASE_H_
+
+#include <stdint.h>
+#include "irq.h"
+
+/*
+ * Timer 2 counts machine cycles at 921.6 kHz (11.0592 MHz / 12) and reloads
+ * every 922 counts: 65536 - 922 = 0xFC66, a 1.0004 ms tick. delay_us reads the
+ * running count, so it keeps time even while the tick interrupt is masked.
+ *
+ * A program's app_config.h may define TIMEBASE_TICK() to run in the ISR on
+ * every tick, and TIMEBASE_TICK_INCLUDE as the header it needs. The ISR keeps
+ * its own register bank, so the hook must call no functions.
+ */
+#define TIMEBASE_RELOAD_H       0xFC
+#define TIMEBASE_RELOAD_L       0x66
+#define TIMEBASE_RELOAD         0xFC66
+#define TIMEBASE_COUNTS_PER_MS  922
+
+/**
+ * @brief   Timer 2 ISR, counts milliseconds and runs TIMEBASE_TICK.
+ * @details Calls nothing, so it runs on its own register bank. The prototype
+ *          must stay visible to main.c for the vector table.
+ */
+void timebase_ISR(void) __interrupt(5) __using(IRQ_BANK(TIMER2));
+
+/**
+ * @brief   Starts the 1 ms tick. Call before any driver that delays.
+ * @return  void
+ */
+void timebase_init(void);
+
+/**
+ * @brief   Returns the free-running millisecond counter.
+ * @details Wraps after about 49 days; compare times with timebase_expired.
+ * @return  Milliseconds since timebase_init.
+ */
+uint32_t millis(void);
+
+/**
+ * @brief   Returns a fine timestamp in Timer 2 counts (1.085 us).
+ * @details Wraps after about 77 minutes; use differences only.
+ * @return  Counts since timebase_init.
+ */
+uint32_t timebase_stamp(void);
+
+/**
+ * @brief   Busy-waits for the given number of microseconds.
+ * @details Resolution is one timer count, 1.085 us. Works with interrupts
+ *          masked as long as Timer 2 runs.
+ * @param   us: Microseconds to wait.
+ * @return  void
+ */
+void delay_us(uint16_t us);
+
+/**
+ * @brief   Waits for the given number of milliseconds.
+ * @details Falls back to delay_us when the tick interrupt cannot run.
+ * @param   ms: Milliseconds to wait.
+ * @return  void
+ */
+void delay_ms(uint16_t ms);
+
+/**
+ * @brief   Returns the millis() value ms milliseconds from now.
+ * @param   ms: Milliseconds until the deadline.
+ * @return  The deadline.
+ */
+uint32_t timebase_deadline(uint16_t ms);
+
+/**
+ * @brief   Checks whether a deadline from timebase_deadline has passed.
+ * @details Safe across the wrap of the millisecond counter.
+ * @param   deadline: The deadline.
+ * @return  1 if it has passed, otherwise 0.
+ */
+uint8_t timebase_expired(uint32_t deadline);
+
+#endif // _TIMEBASE_H_